@@ -36,6 +36,16 @@ static int num_computes;
  */
 static net eval;
 
+/*
+ * Dataset to record evaluated positions and game results to, if any.
+ */
+FILE *ai_record;
+
+/*
+ * Number of simulated games copied, for benchmarks.
+ */
+long ai_num_sim;
+
 /*
  * A neural net for predicting role choices.
  */
@@ -85,6 +95,18 @@ static int eval_cache_hit, eval_cache_miss;
 #define LEADER_GOODS     4
 #define MAX_LEADER       5
 
+/*
+ * Random number streams of samplers and simulated games.
+ */
+#define STREAM_EXPLORE   1
+#define STREAM_PLACE_OPP 2
+#define STREAM_SIMULATE  3
+
+/*
+ * Most random numbers drawn when choosing an opponent's placement.
+ */
+#define MAX_PLACE_DRAW   40
+
 
 /*
  * Forward declaration.
@@ -201,11 +223,27 @@ static void ai_notify_rotation(game *g, int who)
  */
 static void simulate_game(game *sim, game *orig, int who)
 {
+	rng_stream r;
 	int i;
 
 	/* Copy game */
 	memcpy(sim, orig, sizeof(game));
 
+	/* Count simulation */
+	ai_num_sim++;
+
+	/* Check for nested simulation */
+	if (orig->simulation)
+	{
+		/* Go one level deeper (with a sane limit) */
+		if (sim->sim_depth < 100) sim->sim_depth++;
+	}
+	else
+	{
+		/* First level of simulation */
+		sim->sim_depth = 1;
+	}
+
 	/* Loop over players */
 	for (i = 0; i < sim->num_players; i++)
 	{
@@ -219,8 +257,9 @@ static void simulate_game(game *sim, game *orig, int who)
 		/* Set simulation flag */
 		sim->simulation = 1;
 
-		/* Lose real random seed */
-		sim->random_seed = 1;
+		/* Replace real random seed with one from simulation count */
+		rng_seed(&r, ai_num_sim, STREAM_SIMULATE);
+		sim->random_seed = rng_next(&r);
 
 		/* Remember whose point-of-view to use */
 		sim->sim_who = who;
@@ -234,6 +273,48 @@ static void simulate_game(game *sim, game *orig, int who)
 	}
 }
 
+/*
+ * Set of AI functions used in playouts (defined below).
+ */
+static decisions playout_func;
+
+/*
+ * Return true if the given player is choosing for a playout.
+ */
+static int in_playout(game *g, int who)
+{
+	/* Check for playout functions */
+	return g->p[who].control == &playout_func;
+}
+
+/*
+ * Return true if a choice should be made with cheap rules.
+ *
+ * Opponents in simulated games and everyone in a playout choose this way.
+ */
+static int quick_choice(game *g, int who)
+{
+	/* Check for playout */
+	if (in_playout(g, who)) return 1;
+
+	/* Check for simulated opponent */
+	return g->simulation && who != g->sim_who;
+}
+
+/*
+ * Rough value of placing a card, for playouts.
+ */
+static double playout_card_score(game *g, int which)
+{
+	design *d_ptr;
+
+	/* Get card design */
+	d_ptr = g->deck[which].d_ptr;
+
+	/* Count VP and cost (as a guess at power) */
+	return 2 * d_ptr->vp + d_ptr->cost;
+}
+
 /*
  * Structure holding most discardable cards.
  *
@@ -1617,6 +1698,106 @@ static eval_cache *eval_hash[65536];
  */
 static eval_cache *opp_place_hash[65536];
 
+/*
+ * Number of cache entries allocated at once.
+ */
+#define CACHE_BLOCK 1024
+
+/*
+ * Cache entries not currently in use.
+ */
+static eval_cache *free_cache;
+
+/*
+ * Get an unused cache entry.
+ *
+ * Entries are allocated in blocks and are never freed.  Clearing a cache
+ * returns its entries here for the next decision to reuse.
+ */
+static eval_cache *new_cache_entry(void)
+{
+	eval_cache *e_ptr;
+	int i;
+
+	/* Check for no unused entries */
+	if (!free_cache)
+	{
+		/* Allocate block of entries */
+		e_ptr = (eval_cache *)malloc(sizeof(eval_cache) * CACHE_BLOCK);
+
+		/* Add each entry to unused list */
+		for (i = 0; i < CACHE_BLOCK; i++)
+		{
+			/* Add entry */
+			e_ptr[i].next = free_cache;
+			free_cache = &e_ptr[i];
+		}
+	}
+
+	/* Take first unused entry */
+	e_ptr = free_cache;
+	free_cache = e_ptr->next;
+
+	/* Return entry */
+	return e_ptr;
+}
+
+/*
+ * Number of simulated games in each block of the scratch stack.
+ */
+#define SIM_BLOCK 16
+
+/*
+ * Maximum number of blocks in the scratch stack.
+ */
+#define MAX_SIM_BLOCK 64
+
+/*
+ * Scratch stack of simulated games.
+ *
+ * Recursive searches take their simulated games from here instead of
+ * declaring them in every stack frame.  Games must be returned in the
+ * reverse order they were taken, so the stack is empty again once each
+ * decision is made.  Blocks are kept for later decisions to reuse.
+ */
+static game *sim_block[MAX_SIM_BLOCK];
+static int num_sim;
+
+/*
+ * Take a simulated game from the scratch stack.
+ */
+static game *push_sim(void)
+{
+	int n = num_sim / SIM_BLOCK;
+
+	/* Check for full stack */
+	if (n == MAX_SIM_BLOCK)
+	{
+		/* Error */
+		display_error("Simulation stack is full!\n");
+		exit(1);
+	}
+
+	/* Allocate block if needed */
+	if (!sim_block[n])
+	{
+		/* Allocate block */
+		sim_block[n] = (game *)malloc(sizeof(game) * SIM_BLOCK);
+	}
+
+	/* Return next game */
+	return &sim_block[n][num_sim++ % SIM_BLOCK];
+}
+
+/*
+ * Return the last simulated game taken from the scratch stack.
+ */
+static void pop_sim(void)
+{
+	/* Release game */
+	num_sim--;
+}
+
 /*
  * Generic hash mixer.
  */
@@ -1785,7 +1966,7 @@ static eval_cache *lookup_eval(game *g, int who)
 	if (!e_ptr)
 	{
 		/* Make new entry */
-		e_ptr = (eval_cache *)malloc(sizeof(eval_cache));
+		e_ptr = new_cache_entry();
 
 		/* Set key of new entry */
 		e_ptr->key = key;
@@ -1858,7 +2039,7 @@ static eval_cache *lookup_opp_place(game *g, int who, int opp, int which,
 	if (!e_ptr)
 	{
 		/* Make new entry */
-		e_ptr = (eval_cache *)malloc(sizeof(eval_cache));
+		e_ptr = new_cache_entry();
 
 		/* Set key of new entry */
 		e_ptr->key = key;
@@ -1895,8 +2076,9 @@ static void clear_eval_cache(void)
 			/* Move row to next entry */
 			eval_hash[i] = e_ptr->next;
 
-			/* Delete entry */
-			free(e_ptr);
+			/* Return entry to unused list */
+			e_ptr->next = free_cache;
+			free_cache = e_ptr;
 		}
 	}
 }
@@ -1921,8 +2103,9 @@ static void clear_opp_place_cache(void)
 			/* Move row to next entry */
 			opp_place_hash[i] = e_ptr->next;
 
-			/* Delete entry */
-			free(e_ptr);
+			/* Return entry to unused list */
+			e_ptr->next = free_cache;
+			free_cache = e_ptr;
 		}
 	}
 }
@@ -1974,7 +2157,7 @@ static int eval_game_player(game *g, int who, int n, int *leader)
 		c_ptr = &g->deck[x];
 
 		/* Set input for active card */
-		eval.input_value[n + card_input[c_ptr->d_ptr->index]] = 1;
+		set_input(&eval, n + card_input[c_ptr->d_ptr->index], 1);
 
 		/* Loop over card powers */
 		for (i = 0; i < c_ptr->d_ptr->num_power; i++)
@@ -2040,8 +2223,8 @@ static int eval_game_player(game *g, int who, int n, int *leader)
 		good[c_ptr->d_ptr->good_type] = 1;
 
 		/* Set input for card with good */
-		eval.input_value[n + good_input[c_ptr->d_ptr->index]] =
-			c_ptr->num_goods;
+		set_input(&eval, n + good_input[c_ptr->d_ptr->index],
+		          c_ptr->num_goods);
 	}
 
 	/* Advance input index */
@@ -2051,7 +2234,7 @@ static int eval_game_player(game *g, int who, int n, int *leader)
 	for (i = 0; i < 6; i++)
 	{
 		/* Set input if this many goods */
-		eval.input_value[n++] = (count > i) ? 1 : -1;
+		set_input(&eval, n++, (count > i) ? 1 : -1);
 	}
 
 	/* Remember total number of goods */
@@ -2061,7 +2244,7 @@ static int eval_game_player(game *g, int who, int n, int *leader)
 	for (i = GOOD_NOVELTY; i <= GOOD_ALIEN; i++)
 	{
 		/* Set input if good type available */
-		eval.input_value[n++] = good[i] ? 1 : -1;
+		set_input(&eval, n++, good[i] ? 1 : -1);
 	}
 
 	/* Get count of cards in hand */
@@ -2075,7 +2258,7 @@ static int eval_game_player(game *g, int who, int n, int *leader)
 	for (i = 0; i < 12; i++)
 	{
 		/* Set input if this many cards */
-		eval.input_value[n++] = (count > i) ? 1 : -1;
+		set_input(&eval, n++, (count > i) ? 1 : -1);
 	}
 
 	/* Remember cards in hand */
@@ -2085,7 +2268,7 @@ static int eval_game_player(game *g, int who, int n, int *leader)
 	for (i = 0; i < 15; i++)
 	{
 		/* Set input if this many cards seen */
-		eval.input_value[n++] = (p_ptr->drawn_round > i) ? 1 : -1;
+		set_input(&eval, n++, (p_ptr->drawn_round > i) ? 1 : -1);
 	}
 
 	/* Clear count of developments */
@@ -2114,7 +2297,7 @@ static int eval_game_player(game *g, int who, int n, int *leader)
 	for (i = 0; i < 10; i++)
 	{
 		/* Set input if this many cards */
-		eval.input_value[n++] = (count > i) ? 1 : -1;
+		set_input(&eval, n++, (count > i) ? 1 : -1);
 	}
 
 	/* Count number of built cards */
@@ -2143,7 +2326,7 @@ static int eval_game_player(game *g, int who, int n, int *leader)
 	for (i = 0; i < 10; i++)
 	{
 		/* Set input if this many cards */
-		eval.input_value[n++] = (count > i) ? 1 : -1;
+		set_input(&eval, n++, (count > i) ? 1 : -1);
 	}
 
 	/* Count number of built cards */
@@ -2153,7 +2336,7 @@ static int eval_game_player(game *g, int who, int n, int *leader)
 	for (i = 0; i < 5; i++)
 	{
 		/* Set input if this 6-costs */
-		eval.input_value[n++] = (count_six > i) ? 1 : -1;
+		set_input(&eval, n++, (count_six > i) ? 1 : -1);
 	}
 
 	/* Remember amount of cards build */
@@ -2166,20 +2349,20 @@ static int eval_game_player(game *g, int who, int n, int *leader)
 	for (i = 0; i < 10; i++)
 	{
 		/* Set input if this much strength */
-		eval.input_value[n++] = (count > i) ? 1 : -1;
+		set_input(&eval, n++, (count > i) ? 1 : -1);
 	}
 
 	/* Set input if player has conflicting military strength powers */
-	eval.input_value[n++] = (pos_military && neg_military) ? 1 : -1;
+	set_input(&eval, n++, (pos_military && neg_military) ? 1 : -1);
 
 	/* Set input if player skipped last Develop phase */
-	eval.input_value[n++] = p_ptr->skip_develop ? 1 : -1;
+	set_input(&eval, n++, p_ptr->skip_develop ? 1 : -1);
 
 	/* Set input if player skipped last Settle phase */
-	eval.input_value[n++] = p_ptr->skip_settle ? 1 : -1;
+	set_input(&eval, n++, p_ptr->skip_settle ? 1 : -1);
 
 	/* Set input if player has special Explore power */
-	eval.input_value[n++] = explore_mix ? 1 : -1;
+	set_input(&eval, n++, explore_mix ? 1 : -1);
 
 	/* Get amount of consumption ability */
 	count = consume_ability(g, who, 1);
@@ -2188,7 +2371,7 @@ static int eval_game_player(game *g, int who, int n, int *leader)
 	for (i = 0; i < 6; i++)
 	{
 		/* Set input if this much consumption ability */
-		eval.input_value[n++] = (count > i) ? 1 : -1;
+		set_input(&eval, n++, (count > i) ? 1 : -1);
 	}
 
 	/* Get amount of immediate consumption ability */
@@ -2201,7 +2384,7 @@ static int eval_game_player(game *g, int who, int n, int *leader)
 	for (i = 0; i < 6; i++)
 	{
 		/* Set input if this much immediate consumption */
-		eval.input_value[n++] = (count > i) ? 1 : -1;
+		set_input(&eval, n++, (count > i) ? 1 : -1);
 	}
 
 	/* Check for goals in expansion */
@@ -2211,7 +2394,7 @@ static int eval_game_player(game *g, int who, int n, int *leader)
 		for (i = 0; i < MAX_GOAL; i++)
 		{
 			/* Set input if goal claimed */
-			eval.input_value[n++] = p_ptr->goal_claimed[i] ? 1 : -1;
+			set_input(&eval, n++, p_ptr->goal_claimed[i] ? 1 : -1);
 		}
 	}
 
@@ -2219,14 +2402,14 @@ static int eval_game_player(game *g, int who, int n, int *leader)
 	if (g->expanded == 3)
 	{
 		/* Set input if player has used prestige/search action */
-		eval.input_value[n++] = (p_ptr->prestige_action_used ||
-		                         g->game_over) ? 1 : -1;
+		set_input(&eval, n++, (p_ptr->prestige_action_used ||
+		                       g->game_over) ? 1 : -1);
 
 		/* Set inputs for prestige */
 		for (i = 0; i < 15; i++)
 		{
 			/* Set input if this many prestige earned */
-			eval.input_value[n++] = (p_ptr->prestige > i) ? 1 : -1;
+			set_input(&eval, n++, (p_ptr->prestige > i) ? 1 : -1);
 		}
 
 		/* Remember amount of prestige */
@@ -2237,7 +2420,7 @@ static int eval_game_player(game *g, int who, int n, int *leader)
 	leader[LEADER_VP] = p_ptr->end_vp;
 
 	/* Set input if winner */
-	eval.input_value[n++] = p_ptr->winner ? 1 : -1;
+	set_input(&eval, n++, p_ptr->winner ? 1 : -1);
 
 	/* Return next index to be used */
 	return n;
@@ -2269,8 +2452,8 @@ static int eval_game_leader(game *g, int who, int n, int leader[][MAX_LEADER],
 		for (j = 0; j < num_inputs; j++)
 		{
 			/* Add input for this much behind leader */
-			eval.input_value[n++] =
-			                   (leader[i][cat] + j) < max ? 1 : -1;
+			set_input(&eval, n++,
+			          (leader[i][cat] + j) < max ? 1 : -1);
 		}
 
 		/* Advance to next player */
@@ -2320,18 +2503,21 @@ static double eval_game(game *g, int who)
 	/* Declare winner if game over */
 	if (g->game_over) declare_winner(g);
 
+	/* Start from the accumulated sums of the last state at this depth */
+	set_net_depth(&eval, g->simulation ? g->sim_depth : 0);
+
 	/* Clear inputs */
-	for (i = 0; i < eval.num_inputs; i++) eval.input_value[i] = -1;
+	clear_inputs(&eval);
 
 	/* Set input for game over */
-	eval.input_value[n++] = g->game_over ? 1 : -1;
+	set_input(&eval, n++, g->game_over ? 1 : -1);
 
 	/* Set inputs for VP pool size */
 	for (i = 0; i < 12; i++)
 	{
 		/* Set input if this many points (per player) remain */
-		eval.input_value[n++] = (g->vp_pool > i * g->num_players) ?
-		                         1 : -1;
+		set_input(&eval, n++,
+		          (g->vp_pool > i * g->num_players) ? 1 : -1);
 	}
 
 	/* Loop over players */
@@ -2351,7 +2537,7 @@ static double eval_game(game *g, int who)
 	for (i = 0; i < 12; i++)
 	{
 		/* Set input if someone has this many cards played */
-		eval.input_value[n++] = (max_build > i) ? 1 : -1;
+		set_input(&eval, n++, (max_build > i) ? 1 : -1);
 	}
 
 	/* Compute "clock" of time remaining from cards played */
@@ -2371,7 +2557,7 @@ static double eval_game(game *g, int who)
 	for (i = 0; i < 12; i++)
 	{
 		/* Set input if this much time remains */
-		eval.input_value[n++] = (clock > i) ? 1 : -1;
+		set_input(&eval, n++, (clock > i) ? 1 : -1);
 	}
 
 	/* Check for goals in expansion */
@@ -2381,14 +2567,14 @@ static double eval_game(game *g, int who)
 		for (i = 0; i < MAX_GOAL; i++)
 		{
 			/* Set input if this goal is active for this game */
-			eval.input_value[n++] = g->goal_active[i] ? 1 : -1;
+			set_input(&eval, n++, g->goal_active[i] ? 1 : -1);
 		}
 
 		/* Set inputs for available goals */
 		for (i = 0; i < MAX_GOAL; i++)
 		{
 			/* Set input if this goal is still available */
-			eval.input_value[n++] = g->goal_avail[i] ? 1 : -1;
+			set_input(&eval, n++, g->goal_avail[i] ? 1 : -1);
 		}
 	}
 
@@ -2414,7 +2600,7 @@ static double eval_game(game *g, int who)
 		if (g->simulation && g->sim_who != who) continue;
 
 		/* Set input for card in hand */
-		eval.input_value[n + card_input[c_ptr->d_ptr->index]] = 1;
+		set_input(&eval, n + card_input[c_ptr->d_ptr->index], 1);
 	}
 
 	/* Start at first saved card */
@@ -2433,7 +2619,7 @@ static double eval_game(game *g, int who)
 		c_ptr = &g->deck[x];
 
 		/* Set input for saved card */
-		eval.input_value[n + card_input[c_ptr->d_ptr->index]] = 0.5;
+		set_input(&eval, n + card_input[c_ptr->d_ptr->index], 0.5);
 	}
 
 	/* Add simulated drawn cards to handsize */
@@ -2483,14 +2669,14 @@ static double eval_game(game *g, int who)
 	for (i = 0; i < 5; i++)
 	{
 		/* Set input if this many developments available */
-		eval.input_value[n++] = (build_dev > i) ? 1 : -1;
+		set_input(&eval, n++, (build_dev > i) ? 1 : -1);
 	}
 
 	/* Set inputs for buildable worlds in hand */
 	for (i = 0; i < 5; i++)
 	{
 		/* Set input if this many worlds available */
-		eval.input_value[n++] = (build_world > i) ? 1 : -1;
+		set_input(&eval, n++, (build_world > i) ? 1 : -1);
 	}
 
 	/* Set public inputs for given player */
@@ -2538,7 +2724,7 @@ static double eval_game(game *g, int who)
 	}
 
 	/* Compute network */
-	compute_net(&eval);
+	compute_net_sparse(&eval);
 
 	num_computes++;
 
@@ -2609,14 +2795,13 @@ static void perform_training(game *g, int who, double *desired)
 	for (i = eval.num_past - 2; i >= 0; i--)
 	{
 		/* Skip input sets that do not belong to us */
-		if (eval.past_input_player[i] != who) continue;
+		if (past_player(&eval, i) != who) continue;
 
-		/* Copy past inputs to network */
-		memcpy(eval.input_value, eval.past_input[i],
-		       sizeof(double) * (eval.num_inputs + 1));
+		/* Load past inputs into network */
+		load_past(&eval, i);
 
 		/* Compute network */
-		compute_net(&eval);
+		compute_net_sparse(&eval);
 
 		/* Train */
 		train_net(&eval, lambda, target);
@@ -3253,6 +3438,11 @@ static int claim_card(game *g, int who, int which)
  */
 #define MAX_EXPLORE_SAMPLE 10
 
+/*
+ * Number of random Explore results to try for each sample.
+ */
+#define EXPLORE_SAMPLES 10
+
 /*
  * Explore samples we've seen this turn.
  */
@@ -4294,56 +4484,75 @@ static int score_better(double s1, double s2)
 }
 
 /*
- * Helper function for ai_choose_discard().
+ * Score one set of chosen cards for ai_choose_discard_aux().
  */
-static void ai_choose_discard_aux(game *g, int who, int list[], int n, int c,
-                                  int chosen, int *best, double *b_s)
+static void try_discard_set(game *g, int who, int list[], int chosen,
+                            int *best, double *b_s)
 {
-	game sim;
+	game *sim;
 	double score;
 	int discards[MAX_DECK], num_discards = 0;
 	int i;
 
-	/* Check for too few choices */
-	if (c > n) return;
-
-	/* Check for end */
-	if (!n)
+	/* Loop over chosen cards */
+	for (i = 0; (1 << i) <= chosen; i++)
 	{
-		/* Loop over chosen cards */
-		for (i = 0; (1 << i) <= chosen; i++)
+		/* Check for bit set */
+		if (chosen & (1 << i))
 		{
-			/* Check for bit set */
-			if (chosen & (1 << i))
-			{
-				/* Add card to list */
-				discards[num_discards++] = list[i];
-			}
+			/* Add card to list */
+			discards[num_discards++] = list[i];
 		}
+	}
 
-		/* Copy game */
-		simulate_game(&sim, g, who);
+	/* Take scratch game */
+	sim = push_sim();
 
-		/* Apply choice */
-		discard_callback(&sim, who, discards, num_discards);
+	/* Copy game */
+	simulate_game(sim, g, who);
 
-		/* Check for explore phase */
-		if (sim.cur_action == ACT_EXPLORE_5_0)
-		{
-			/* Simulate most rest of turn */
-			complete_turn(&sim, COMPLETE_ROUND);
-		}
+	/* Apply choice */
+	discard_callback(sim, who, discards, num_discards);
 
-		/* Evaluate result */
-		score = eval_game(&sim, who);
+	/* Check for explore phase */
+	if (sim->cur_action == ACT_EXPLORE_5_0)
+	{
+		/* Simulate most rest of turn */
+		complete_turn(sim, COMPLETE_ROUND);
+	}
 
-		/* Check for better score */
-		if (score_better(score, *b_s))
-		{
-			/* Save better choice */
-			*b_s = score;
-			*best = chosen;
-		}
+	/* Evaluate result */
+	score = eval_game(sim, who);
+
+	/* Release scratch game */
+	pop_sim();
+
+	/* Check for better score */
+	if (score_better(score, *b_s))
+	{
+		/* Save better choice */
+		*b_s = score;
+		*best = chosen;
+	}
+}
+
+/*
+ * Helper function for ai_choose_discard().
+ *
+ * The simulated games and card lists live in try_discard_set(), so each
+ * level of recursion stays small.
+ */
+static void ai_choose_discard_aux(game *g, int who, int list[], int n, int c,
+                                  int chosen, int *best, double *b_s)
+{
+	/* Check for too few choices */
+	if (c > n) return;
+
+	/* Check for end */
+	if (!n)
+	{
+		/* Score chosen set */
+		try_discard_set(g, who, list, chosen, best, b_s);
 
 		/* Done */
 		return;
@@ -4358,97 +4567,115 @@ static void ai_choose_discard_aux(game *g, int who, int list[], int n, int c,
 }
 
 /*
- * Helper function for ai_choose_discard().
+ * Score one set of chosen cards for ai_choose_discard_aux_action().
  */
-static void ai_choose_discard_aux_action(game *g, int who, int list[], int n,
-					 int c, int chosen, int *best,
-					 double *b_s)
+static void try_discard_set_action(game *g, int who, int list[], int chosen,
+                                   int *best, double *b_s)
 {
-	game sim, sim2;
+	game *sim, *sim2;
 	double score;
 	int discards[MAX_DECK], num_discards = 0;
 	int i;
 
-	/* Check for too few choices */
-	if (c > n) return;
-
-	/* Check for end */
-	if (!n)
+	/* Loop over chosen cards */
+	for (i = 0; (1 << i) <= chosen; i++)
 	{
-		/* Loop over chosen cards */
-		for (i = 0; (1 << i) <= chosen; i++)
+		/* Check for bit set */
+		if (chosen & (1 << i))
 		{
-			/* Check for bit set */
-			if (chosen & (1 << i))
-			{
-				/* Add card to list */
-				discards[num_discards++] = list[i];
-			}
+			/* Add card to list */
+			discards[num_discards++] = list[i];
 		}
+	}
 
-		/* Copy game */
-		simulate_game(&sim, g, who);
+	/* Take scratch games */
+	sim = push_sim();
+	sim2 = push_sim();
 
-		/* Apply choice */
-		discard_callback(&sim, who, discards, num_discards);
+	/* Copy game */
+	simulate_game(sim, g, who);
 
-		/* Loop over other players */
-		for (i = 0; i < g->num_players; i++)
+	/* Apply choice */
+	discard_callback(sim, who, discards, num_discards);
+
+	/* Loop over other players */
+	for (i = 0; i < g->num_players; i++)
+	{
+		/* Skip ourself */
+		if (i == who) continue;
+
+		/* Make starting discards */
+		sim->p[i].fake_discards = 2;
+	}
+
+	/* Loop over possible action choices for first turn */
+	for (i = 0; i < role.num_output; i++)
+	{
+		/* Simulate game */
+		simulate_game(sim2, sim, who);
+
+		/* Check for advanced game */
+		if (!g->advanced)
 		{
-			/* Skip ourself */
-			if (i == who) continue;
+			/* Disallow prestige actions */
+			if (role_out[i] & ACT_PRESTIGE) continue;
 
-			/* Make starting discards */
-			sim.p[i].fake_discards = 2;
+			/* Set actions */
+			sim2->p[who].action[0] = role_out[i];
+			sim2->p[who].action[1] = -1;
 		}
-
-		/* Loop over possible action choices for first turn */
-		for (i = 0; i < role.num_output; i++)
+		else
 		{
-			/* Simulate game */
-			simulate_game(&sim2, &sim, who);
+			/* Disallow prestige actions */
+			if (adv_combo[i][0] & ACT_PRESTIGE) continue;
+			if (adv_combo[i][1] & ACT_PRESTIGE) continue;
 
-			/* Check for advanced game */
-			if (!g->advanced)
-			{
-				/* Disallow prestige actions */
-				if (role_out[i] & ACT_PRESTIGE) continue;
+			/* Set actions */
+			sim2->p[who].action[0] = adv_combo[i][0];
+			sim2->p[who].action[1] = adv_combo[i][1];
+		}
 
-				/* Set actions */
-				sim2.p[who].action[0] = role_out[i];
-				sim2.p[who].action[1] = -1;
-			}
-			else
-			{
-				/* Disallow prestige actions */
-				if (adv_combo[i][0] & ACT_PRESTIGE) continue;
-				if (adv_combo[i][1] & ACT_PRESTIGE) continue;
+		/* Note actions */
+		note_actions(sim2);
 
-				/* Set actions */
-				sim2.p[who].action[0] = adv_combo[i][0];
-				sim2.p[who].action[1] = adv_combo[i][1];
-			}
+		/* Start at beginning of first turn */
+		sim2->cur_action = ACT_ROUND_START;
 
-			/* Note actions */
-			note_actions(&sim2);
+		/* Complete turn */
+		complete_turn(sim2, COMPLETE_ROUND);
 
-			/* Start at beginning of first turn */
-			sim2.cur_action = ACT_ROUND_START;
+		/* Evaluate results of first turn */
+		score = eval_game(sim2, who);
 
-			/* Complete turn */
-			complete_turn(&sim2, COMPLETE_ROUND);
+		/* Check for better score */
+		if (score_better(score, *b_s))
+		{
+			/* Save better choice */
+			*b_s = score;
+			*best = chosen;
+		}
+	}
 
-			/* Evaluate results of first turn */
-			score = eval_game(&sim2, who);
+	/* Release scratch games */
+	pop_sim();
+	pop_sim();
+}
 
-			/* Check for better score */
-			if (score_better(score, *b_s))
-			{
-				/* Save better choice */
-				*b_s = score;
-				*best = chosen;
-			}
-		}
+/*
+ * Helper function for ai_choose_discard().
+ */
+static void ai_choose_discard_aux_action(game *g, int who, int list[], int n,
+					 int c, int chosen, int *best,
+					 double *b_s)
+{
+	/* Check for too few choices */
+	if (c > n) return;
+
+	/* Check for end */
+	if (!n)
+	{
+		/* Score chosen set */
+		try_discard_set_action(g, who, list, chosen, best, b_s);
 
 		/* Done */
 		return;
@@ -4464,28 +4691,164 @@ static void ai_choose_discard_aux_action(game *g, int who, int list[], int n,
 }
 
 /*
- * Choose cards to discard.
+ * Number of partial discard sets kept at each step of the discard search.
  */
-static void ai_choose_discard(game *g, int who, int list[], int *num,
-                              int discard)
-{
-	game sim;
-	player *p_ptr;
-	double b_s = -1, score, percard[MAX_DECK];
-	int discards[MAX_DECK], n = 0;
-	int best, i, j, b_i;
+#define DISCARD_BEAM 4
 
-	/* Get player pointer */
-	p_ptr = &g->p[who];
+/*
+ * Most discard sets to search exhaustively.
+ */
+#define DISCARD_EXHAUST 256
 
-	/* Check for simulated game */
-	if (g->simulation)
-	{
-		/* Track cards discarded */
-		p_ptr->fake_discards += discard;
+/*
+ * A partial set of cards to discard.
+ */
+typedef struct discard_set
+{
+	/* Set of chosen cards from list */
+	int chosen;
 
-		/* Don't actually discard anything */
-		*num = 0;
+	/* Score with chosen cards discarded */
+	double score;
+
+} discard_set;
+
+/*
+ * Return the number of ways to choose k of n items.
+ */
+static int count_subsets(int n, int k)
+{
+	int i, x = 1;
+
+	/* Check for impossible choice */
+	if (k < 0 || k > n) return 0;
+
+	/* Multiply out */
+	for (i = 0; i < k; i++) x = x * (n - i) / (i + 1);
+
+	/* Return count */
+	return x;
+}
+
+/*
+ * Helper function for ai_choose_discard().
+ *
+ * Extend each partial discard set in the beam by one more card, and keep
+ * the best extended sets.  Each card's score is taken with the cards not
+ * yet chosen counted as fake discards, so the first step scores each
+ * card's marginal contribution to the hand.
+ */
+static void ai_choose_discard_beam(game *g, int who, int list[], int num,
+                                   int discard, int k, discard_set beam[],
+                                   int *num_beam)
+{
+	game sim;
+	discard_set next[DISCARD_BEAM * MAX_DECK], temp;
+	int discards[MAX_DECK], n;
+	int i, j, l, chosen, num_next = 0;
+
+	/* Loop over current partial sets */
+	for (i = 0; i < *num_beam; i++)
+	{
+		/* Loop over cards */
+		for (j = 0; j < num; j++)
+		{
+			/* Skip cards already chosen */
+			if (beam[i].chosen & (1 << j)) continue;
+
+			/* Extend set */
+			chosen = beam[i].chosen | (1 << j);
+
+			/* Loop over sets already tried */
+			for (l = 0; l < num_next; l++)
+			{
+				/* Check for same set */
+				if (next[l].chosen == chosen) break;
+			}
+
+			/* Skip duplicate sets */
+			if (l < num_next) continue;
+
+			/* Clear discard list */
+			n = 0;
+
+			/* Loop over chosen cards */
+			for (l = 0; l < num; l++)
+			{
+				/* Add chosen card to list */
+				if (chosen & (1 << l)) discards[n++] = list[l];
+			}
+
+			/* Simulate game */
+			simulate_game(&sim, g, who);
+
+			/* Discard chosen cards */
+			discard_callback(&sim, who, discards, n);
+
+			/* Mark rest as fake discards */
+			sim.p[who].fake_discards += discard - (k + 1);
+
+			/* Check for explore phase */
+			if (sim.cur_action == ACT_EXPLORE_5_0)
+			{
+				/* Simulate most rest of turn */
+				complete_turn(&sim, COMPLETE_ROUND);
+			}
+
+			/* Save extended set and its score */
+			next[num_next].chosen = chosen;
+			next[num_next++].score = eval_game(&sim, who);
+		}
+	}
+
+	/* Keep best extended sets */
+	for (i = 0; i < DISCARD_BEAM && i < num_next; i++)
+	{
+		/* Loop over remaining sets */
+		for (j = i + 1; j < num_next; j++)
+		{
+			/* Check for better set */
+			if (next[j].score > next[i].score)
+			{
+				/* Swap sets */
+				temp = next[i];
+				next[i] = next[j];
+				next[j] = temp;
+			}
+		}
+
+		/* Save set */
+		beam[i] = next[i];
+	}
+
+	/* Set number of sets kept */
+	*num_beam = i;
+}
+
+/*
+ * Choose cards to discard.
+ */
+static void ai_choose_discard(game *g, int who, int list[], int *num,
+                              int discard)
+{
+	game sim;
+	player *p_ptr;
+	discard_set beam[DISCARD_BEAM];
+	double b_s = -1, percard[MAX_DECK];
+	int discards[MAX_DECK], n = 0, rest[MAX_DECK], num_rest;
+	int best, i, j, b_i, k, num_beam, set_best = 0, action;
+
+	/* Get player pointer */
+	p_ptr = &g->p[who];
+
+	/* Check for simulated game */
+	if (g->simulation)
+	{
+		/* Track cards discarded */
+		p_ptr->fake_discards += discard;
+
+		/* Don't actually discard anything */
+		*num = 0;
 
 		/* Done */
 		return;
@@ -4543,81 +4906,83 @@ static void ai_choose_discard(game *g, int who, int list[], int *num,
 		return;
 	}
 
-	/* XXX - Check for lots of cards and discards */
-	while (*num > 5 && discard > 2 && *num - discard > 2)
-	{
-		/* Clear best score */
-		b_s = b_i = -1;
-
-		/* Discard worst card */
-		for (i = 0; i < *num; i++)
-		{
-			/* Simulate game */
-			simulate_game(&sim, g, who);
+	/* Start with a single empty set of discards */
+	beam[0].chosen = 0;
+	beam[0].score = -1;
+	num_beam = 1;
 
-			/* Discard previously discarded cards */
-			discard_callback(&sim, who, discards, n);
+	/*
+	 * Grow the best partial sets a card at a time until the ways to
+	 * complete them are few enough to search exhaustively.
+	 */
+	for (k = 0; num_beam * count_subsets(*num - k, discard - k) >
+	            DISCARD_EXHAUST; k++)
+	{
+		/* Extend partial sets by one card */
+		ai_choose_discard_beam(g, who, list, *num, discard, k, beam,
+		                       &num_beam);
+	}
 
-			/* Discard one */
-			discard_callback(&sim, who, &list[i], 1);
+	/* Check for action selection to happen after discarding */
+	action = !g->simulation && g->cur_action == ACT_ROUND_START &&
+	         g->round == 0;
 
-			/* Mark rest as fake discards */
-			sim.p[who].fake_discards += discard - 1;
+	/* Check for deeper search */
+	if (action)
+	{
+		/* Clear explore and place samples */
+		ai_sample_clear();
+		clear_opp_place_cache();
+	}
 
-			/* Check for explore phase */
-			if (sim.cur_action == ACT_EXPLORE_5_0)
-			{
-				/* Simulate most rest of turn */
-				complete_turn(&sim, COMPLETE_ROUND);
-			}
+	/* Assume first partial set is best */
+	b_i = 0;
 
-			/* Evaluate game */
-			score = eval_game(&sim, who);
+	/* Loop over partial sets */
+	for (i = 0; i < num_beam; i++)
+	{
+		/* Clear lists of partial discards and remaining cards */
+		n = num_rest = 0;
 
-			/* Check for better score */
-			if (score_better(score, b_s))
-			{
-				/* Track best */
-				b_s = score;
-				b_i = i;
-			}
+		/* Loop over cards */
+		for (j = 0; j < *num; j++)
+		{
+			/* Add card to discards or remaining cards */
+			if (beam[i].chosen & (1 << j)) discards[n++] = list[j];
+			else rest[num_rest++] = list[j];
 		}
 
-		/* Discard worst card */
-		discards[n++] = list[b_i];
-
-		/* Move last card into given spot */
-		list[b_i] = list[--(*num)];
-
-		/* One less card to discard */
-		discard--;
-	}
-
-	/* Clear best score */
-	b_s = -1;
+		/* Simulate game */
+		simulate_game(&sim, g, who);
 
-	/* Simulate game */
-	simulate_game(&sim, g, who);
+		/* Discard already chosen cards */
+		discard_callback(&sim, who, discards, n);
 
-	/* Discard already chosen cards */
-	discard_callback(&sim, who, discards, n);
+		/* Clear best completion of this set */
+		best = -1;
 
-	/* Check for action selection to happen after discarding */
-	if (!g->simulation && g->cur_action == ACT_ROUND_START && g->round == 0)
-	{
-		/* Clear explore and place samples */
-		ai_sample_clear();
-		clear_opp_place_cache();
+		/* Check for deeper search */
+		if (action)
+		{
+			/* Do deeper search for discarded cards */
+			ai_choose_discard_aux_action(&sim, who, rest, num_rest,
+			                             discard - k, 0, &best,
+			                             &b_s);
+		}
+		else
+		{
+			/* Find best set of remaining cards */
+			ai_choose_discard_aux(&sim, who, rest, num_rest,
+			                      discard - k, 0, &best, &b_s);
+		}
 
-		/* Do deeper search for discarded cards */
-		ai_choose_discard_aux_action(&sim, who, list, *num, discard, 0,
-					     &best, &b_s);
-	}
-	else
-	{
-		/* Find best set of cards */
-		ai_choose_discard_aux(&sim, who, list, *num, discard, 0,
-				      &best, &b_s);
+		/* Check for new best set */
+		if (best != -1)
+		{
+			/* Remember partial set and completion */
+			b_i = i;
+			set_best = best;
+		}
 	}
 
 	/* Check for failure */
@@ -4628,17 +4993,36 @@ static void ai_choose_discard(game *g, int who, int list[], int *num,
 		abort();
 	}
 
-	/* Loop over set of chosen cards */
-	for (i = 0; (1 << i) <= best; i++)
+	/* Clear discard list */
+	n = 0;
+
+	/* Loop over cards */
+	for (i = 0; i < *num; i++)
 	{
-		/* Check for bit set */
-		if (best & (1 << i))
+		/* Check for card in best partial set */
+		if (beam[b_i].chosen & (1 << i))
 		{
 			/* Add card to discard list */
 			discards[n++] = list[i];
 		}
 	}
 
+	/* Clear count of remaining cards */
+	num_rest = 0;
+
+	/* Loop over cards not in best partial set */
+	for (i = 0; i < *num; i++)
+	{
+		/* Skip cards in partial set */
+		if (beam[b_i].chosen & (1 << i)) continue;
+
+		/* Check for card in best completion */
+		if (set_best & (1 << num_rest)) discards[n++] = list[i];
+
+		/* Count remaining card */
+		num_rest++;
+	}
+
 	/* Copy discards to list */
 	for (i = 0; i < n; i++)
 	{
@@ -4929,6 +5313,74 @@ static void ai_explore_sample_apply(game *g, int who, int draw, int keep,
 	g->p[who].fake_discards = 0;
 }
 
+/*
+ * Take one random sample of Explore results.
+ *
+ * The drawn cards are taken from the unknown list and put back at its
+ * end afterwards.
+ */
+static void ai_explore_sample_one(game *g, int who, int draw, int keep,
+                                  int discard_any, int unknown[],
+                                  int num_unknown, int iter,
+                                  struct sample_score *s_ptr)
+{
+	game sim;
+	rng_stream r;
+	int j, k;
+
+	/* Simulate game */
+	simulate_game(&sim, g, who);
+
+	/* Use iteration as seed */
+	rng_seed(&r, iter, STREAM_EXPLORE);
+
+	/* Pick cards from unknown list */
+	for (j = 0; j < draw; j++)
+	{
+		/* Choose card at random */
+		k = rng_below(&r, num_unknown);
+
+		/* Claim card for ourself */
+		claim_card(&sim, who, unknown[k]);
+
+		/* Mark card as fake */
+		sim.deck[unknown[k]].misc |= MISC_FAKE;
+
+		/* Add claimed card to list for this iteration */
+		s_ptr->list[j] = unknown[k];
+
+		/* Remove card from list */
+		unknown[k] = unknown[--num_unknown];
+	}
+
+	/* Find worst cards */
+	ai_explore_sample_aux(&sim, who, draw, keep, discard_any,
+	                      s_ptr->discards);
+
+	/* Discard worst */
+	discard_callback(&sim, who, s_ptr->discards, draw - keep);
+
+	/* Clear fake card counts */
+	sim.p[who].drawn_round = 0;
+	sim.p[who].fake_hand = 0;
+	sim.p[who].fake_discards = 0;
+
+	/* Score game */
+	s_ptr->score = eval_game(&sim, who);
+
+	/* Save parameters */
+	s_ptr->drawn = draw;
+	s_ptr->keep = keep;
+	s_ptr->discard_any = discard_any;
+
+	/* Put chosen cards back in unknown list */
+	for (j = 0; j < draw; j++)
+	{
+		/* Add back to list */
+		unknown[num_unknown++] = s_ptr->list[j];
+	}
+}
+
 /*
  * Place a representative sample of possible cards from an Explore phase
  * in our hand.
@@ -4936,12 +5388,10 @@ static void ai_explore_sample_apply(game *g, int who, int draw, int keep,
 static void ai_explore_sample(game *g, int who, int draw, int keep,
                               int discard_any)
 {
-	game sim;
 	card *c_ptr;
 	int unknown[MAX_DECK], num_unknown = 0;
-	struct sample_score scores[10];
-	int i, j, k;
-	unsigned int seed;
+	struct sample_score scores[EXPLORE_SAMPLES];
+	int i;
 
 	/* Loop over previous results */
 	for (i = 0; i < MAX_EXPLORE_SAMPLE; i++)
@@ -4961,7 +5411,14 @@ static void ai_explore_sample(game *g, int who, int draw, int keep,
 		return;
 	}
 
-	/* Loop over deck */
+	/*
+	 * Build list of unknown cards.
+	 *
+	 * Skipping our hand and the active cards using their card sets
+	 * first was tried, but most cards are still unknown when we
+	 * explore, so it was slower than this scan (about 150 ns against
+	 * 120 ns), and both are small next to one simulated game.
+	 */
 	for (i = 0; i < g->deck_size; i++)
 	{
 		/* Get card pointer */
@@ -4976,66 +5433,16 @@ static void ai_explore_sample(game *g, int who, int draw, int keep,
 	}
 
 	/* Try multiple random samples */
-	for (i = 0; i < 10; i++)
+	for (i = 0; i < EXPLORE_SAMPLES; i++)
 	{
-		/* Simulate game */
-		simulate_game(&sim, g, who);
-
-		/* Use iteration as seed */
-		seed = i;
-
-		/* Pick cards from unknown list */
-		for (j = 0; j < draw; j++)
-		{
-			/* Choose card at random */
-			k = simple_rand(&seed) % num_unknown;
-
-			/* Claim card for ourself */
-			claim_card(&sim, who, unknown[k]);
-
-			/* Mark card as fake */
-			sim.deck[unknown[k]].misc |= MISC_FAKE;
-
-			/* Add claimed card to list for this iteration */
-			scores[i].list[j] = unknown[k];
-
-			/* Remove card from list */
-			unknown[k] = unknown[--num_unknown];
-		}
-
-		/* Find worst cards */
-		ai_explore_sample_aux(&sim, who, draw, keep, discard_any,
-		                      scores[i].discards);
-
-		/* Discard worst */
-		discard_callback(&sim, who, scores[i].discards, draw - keep);
-
-		/* Clear fake card counts */
-		sim.p[who].drawn_round = 0;
-		sim.p[who].fake_hand = 0;
-		sim.p[who].fake_discards = 0;
-
-		/* Score game */
-		scores[i].score = eval_game(&sim, who);
-
-		/* Save parameters */
-		scores[i].drawn = draw;
-		scores[i].keep = keep;
-		scores[i].discard_any = discard_any;
-
-		/* Put chosen cards back in unknown list */
-		for (j = 0; j < draw; j++)
-		{
-			/* Add back to list */
-			unknown[num_unknown++] = scores[i].list[j];
-		}
+		/* Sample Explore results */
+		ai_explore_sample_one(g, who, draw, keep, discard_any, unknown,
+		                      num_unknown, i, &scores[i]);
 	}
 
 	/* Sort list of scores */
-	qsort(scores, 10, sizeof(struct sample_score), cmp_sample_score);
-
-	/* Use second-worst sample */
-	j = 1;
+	qsort(scores, EXPLORE_SAMPLES, sizeof(struct sample_score),
+	      cmp_sample_score);
 
 	/* Loop over previous explore sample results */
 	for (i = 0; i < MAX_EXPLORE_SAMPLE; i++)
@@ -5043,8 +5450,8 @@ static void ai_explore_sample(game *g, int who, int draw, int keep,
 		/* Skip already valid results */
 		if (explore_seen[i].valid) continue;
 
-		/* Copy results */
-		memcpy(&explore_seen[i], &scores[j],
+		/* Copy second-worst sample */
+		memcpy(&explore_seen[i], &scores[1],
 		       sizeof(struct sample_score));
 
 		/* Mark as valid */
@@ -5063,103 +5470,121 @@ static void ai_explore_sample(game *g, int who, int draw, int keep,
 }
 
 /*
- * Helper function for ai_choose_start() below.
+ * Score one set of chosen cards for ai_choose_start_aux().
  */
-static void ai_choose_start_aux(game *g, int who, int list[], int n, int c,
-                                int chosen, int *best, double *b_s, int start)
+static void try_start_set(game *g, int who, int list[], int chosen, int *best,
+                          double *b_s, int start)
 {
-	game sim, sim2;
+	game *sim, *sim2;
 	double score;
 	int discards[MAX_DECK], num_discards = 0;
 	int i;
 	int special[1];
 
-	/* Check for too few choices */
-	if (c > n) return;
-
-	/* Check for end */
-	if (!n)
+	/* Loop over chosen cards */
+	for (i = 0; (1 << i) <= chosen; i++)
 	{
-		/* Loop over chosen cards */
-		for (i = 0; (1 << i) <= chosen; i++)
+		/* Check for bit set */
+		if (chosen & (1 << i))
 		{
-			/* Check for bit set */
-			if (chosen & (1 << i))
-			{
-				/* Add card to list */
-				discards[num_discards++] = list[i];
-			}
+			/* Add card to list */
+			discards[num_discards++] = list[i];
 		}
+	}
 
-		/* Copy game */
-		simulate_game(&sim, g, who);
+	/* Take scratch games */
+	sim = push_sim();
+	sim2 = push_sim();
+
+	/* Copy game */
+	simulate_game(sim, g, who);
 
-		/* Create special array */
-		special[0] = start;
+	/* Create special array */
+	special[0] = start;
 
-		/* Apply choice */
-		start_callback(&sim, who, discards, num_discards, special, 1);
+	/* Apply choice */
+	start_callback(sim, who, discards, num_discards, special, 1);
 
-		/* Handle special abilites of start world */
-		start_chosen(&sim);
+	/* Handle special abilites of start world */
+	start_chosen(sim);
 
-		/* Loop over players */
-		for (i = 0; i < g->num_players; i++)
+	/* Loop over players */
+	for (i = 0; i < g->num_players; i++)
+	{
+		/* Skip ourself */
+		if (i == who) continue;
+
+		/* Assume opponent will discard 2 */
+		sim->p[i].fake_discards = 2;
+	}
+
+	/* Loop over possible action choices for first turn */
+	for (i = 0; i < role.num_output; i++)
+	{
+		/* Simulate game */
+		simulate_game(sim2, sim, who);
+
+		/* Check for advanced game */
+		if (!g->advanced)
 		{
-			/* Skip ourself */
-			if (i == who) continue;
+			/* Disallow prestige actions */
+			if (role_out[i] & ACT_PRESTIGE) continue;
 
-			/* Assume opponent will discard 2 */
-			sim.p[i].fake_discards = 2;
+			/* Set actions */
+			sim2->p[who].action[0] = role_out[i];
+			sim2->p[who].action[1] = -1;
 		}
-
-		/* Loop over possible action choices for first turn */
-		for (i = 0; i < role.num_output; i++)
+		else
 		{
-			/* Simulate game */
-			simulate_game(&sim2, &sim, who);
+			/* Disallow prestige actions */
+			if (adv_combo[i][0] & ACT_PRESTIGE) continue;
+			if (adv_combo[i][1] & ACT_PRESTIGE) continue;
 
-			/* Check for advanced game */
-			if (!g->advanced)
-			{
-				/* Disallow prestige actions */
-				if (role_out[i] & ACT_PRESTIGE) continue;
+			/* Set actions */
+			sim2->p[who].action[0] = adv_combo[i][0];
+			sim2->p[who].action[1] = adv_combo[i][1];
+		}
 
-				/* Set actions */
-				sim2.p[who].action[0] = role_out[i];
-				sim2.p[who].action[1] = -1;
-			}
-			else
-			{
-				/* Disallow prestige actions */
-				if (adv_combo[i][0] & ACT_PRESTIGE) continue;
-				if (adv_combo[i][1] & ACT_PRESTIGE) continue;
+		/* Note actions */
+		note_actions(sim2);
 
-				/* Set actions */
-				sim2.p[who].action[0] = adv_combo[i][0];
-				sim2.p[who].action[1] = adv_combo[i][1];
-			}
+		/* Start at beginning of first turn */
+		sim2->cur_action = ACT_ROUND_START;
 
-			/* Note actions */
-			note_actions(&sim2);
+		/* Complete turn */
+		complete_turn(sim2, COMPLETE_ROUND);
 
-			/* Start at beginning of first turn */
-			sim2.cur_action = ACT_ROUND_START;
+		/* Evaluate results of first turn */
+		score = eval_game(sim2, who);
 
-			/* Complete turn */
-			complete_turn(&sim2, COMPLETE_ROUND);
+		/* Check for better score */
+		if (score_better(score, *b_s))
+		{
+			/* Save better choice */
+			*b_s = score;
+			*best = chosen;
+		}
+	}
 
-			/* Evaluate results of first turn */
-			score = eval_game(&sim2, who);
+	/* Release scratch games */
+	pop_sim();
+	pop_sim();
+}
 
-			/* Check for better score */
-			if (score_better(score, *b_s))
-			{
-				/* Save better choice */
-				*b_s = score;
-				*best = chosen;
-			}
-		}
+/*
+ * Helper function for ai_choose_start() below.
+ */
+static void ai_choose_start_aux(game *g, int who, int list[], int n, int c,
+                                int chosen, int *best, double *b_s, int start)
+{
+	/* Check for too few choices */
+	if (c > n) return;
+
+	/* Check for end */
+	if (!n)
+	{
+		/* Score chosen set */
+		try_start_set(g, who, list, chosen, best, b_s, start);
 
 		/* Done */
 		return;
@@ -5299,12 +5724,13 @@ static int ai_choose_place_opp(game *g, int who, int phase, int special)
 	game sim;
 	card *c_ptr;
 	int i, j, n = 0, type;
-	unsigned int seed;
+	rng_stream r;
 	power *o_ptr;
 	int mil_only = 0, max = 0, reduce;
 	int hand_size, extra_count = 0;
 	int windfall_only = 0, force_place = 0;
 	int unknown[MAX_DECK], num_unknown = 0;
+	uint32_t pick[MAX_PLACE_DRAW];
 	double score, no_place;
 	eval_cache *e_ptr;
 	struct sample_score scores[MAX_DECK];
@@ -5416,7 +5842,10 @@ static int ai_choose_place_opp(game *g, int who, int phase, int special)
 	if (hand_size > 20) hand_size = 20;
 
 	/* Use fake random seed */
-	seed = 0;
+	rng_seed(&r, 0, STREAM_PLACE_OPP);
+
+	/* Draw card choices for every sample and forced retry */
+	rng_fill_below(&r, pick, hand_size + 20, num_unknown);
 
 	/* Loop over number of cards seen */
 	for (i = 0; i < hand_size; i++)
@@ -5430,7 +5859,7 @@ static int ai_choose_place_opp(game *g, int who, int phase, int special)
 		}
 
 		/* Choose card at random */
-		j = simple_rand(&seed) % num_unknown;
+		j = pick[i + extra_count];
 
 		/* Get card pointer */
 		c_ptr = &g->deck[unknown[j]];
@@ -5454,6 +5883,15 @@ static int ai_choose_place_opp(game *g, int who, int phase, int special)
 				continue;
 		}
 
+		/* Check for playout */
+		if (in_playout(g, who))
+		{
+			/* Use rough score */
+			scores[n].list[0] = unknown[j];
+			scores[n++].score = playout_card_score(g, unknown[j]);
+			continue;
+		}
+
 		/* Get pointer to cache entry */
 		e_ptr = lookup_opp_place(g, g->sim_who, who, unknown[j],
 		                         special);
@@ -5492,26 +5930,35 @@ static int ai_choose_place_opp(game *g, int who, int phase, int special)
 	/* Check for no legal placements made */
 	if (!n) return -1;
 
-	/* Get pointer to cache score */
-	e_ptr = lookup_opp_place(g, g->sim_who, who, -1, special);
-
-	/* Check for score in no-placement cache */
-	if (e_ptr->score != -1)
+	/* Check for playout */
+	if (in_playout(g, who))
 	{
-		/* Get score from cache */
-		no_place = e_ptr->score;
+		/* Placing nothing earns nothing */
+		no_place = 0;
 	}
 	else
 	{
-		/* Simulate game */
-		simulate_game(&sim, g, who);
+		/* Get pointer to cache score */
+		e_ptr = lookup_opp_place(g, g->sim_who, who, -1, special);
 
-		/* Get score for placing no card */
-		no_place = ai_choose_place_opp_aux(&sim, who, -1, phase,
-						   special);
+		/* Check for score in no-placement cache */
+		if (e_ptr->score != -1)
+		{
+			/* Get score from cache */
+			no_place = e_ptr->score;
+		}
+		else
+		{
+			/* Simulate game */
+			simulate_game(&sim, g, who);
+
+			/* Get score for placing no card */
+			no_place = ai_choose_place_opp_aux(&sim, who, -1,
+			                                   phase, special);
 
-		/* Store score in cache */
-		e_ptr->score = no_place;
+			/* Store score in cache */
+			e_ptr->score = no_place;
+		}
 	}
 
 	/* Skip adding no place scores if placement is forced */
@@ -5590,6 +6037,28 @@ static int ai_choose_place(game *g, int who, int list[], int num, int phase,
 	/* Check for no choices */
 	if (!num) return -1;
 
+	/* Check for playout */
+	if (in_playout(g, who))
+	{
+		/* Assume first card is best */
+		best = list[0];
+
+		/* Loop over choices */
+		for (i = 1; i < num; i++)
+		{
+			/* Check for better rough score */
+			if (playout_card_score(g, list[i]) >
+			    playout_card_score(g, best))
+			{
+				/* Track best */
+				best = list[i];
+			}
+		}
+
+		/* Place best card */
+		return best;
+	}
+
 	/* Check for additional placement */
 	if (!additional)
 	{
@@ -5749,19 +6218,88 @@ static int ai_choose_place(game *g, int who, int list[], int num, int phase,
 			printf("-- Score for %s: %f\n", g->deck[list[i]].d_ptr->name, score);
 			dump_game(g, &sim2);
 		}
-#endif
+#endif
+
+		/* Check for better */
+		if (score_better(score, b_s))
+		{
+			/* Track best */
+			b_s = score;
+			best = list[i];
+		}
+	}
+
+	/* Return best choice */
+	return best;
+}
+
+/*
+ * Score one combination of payment for ai_choose_pay_aux2().
+ */
+static void try_payment(game *g, int who, int which, int list[],
+                        int special[], int num_special, int mil_only,
+                        int mil_bonus, int chosen, int chosen_special,
+                        int *best, int *best_special, double *b_s)
+{
+	game *sim;
+	int payment[MAX_DECK], num_payment = 0, used[MAX_DECK], n_used = 0;
+	double score;
+	int i;
+
+	/* Loop over chosen special cards */
+	for (i = 0; i < num_special; i++)
+	{
+		/* Check for bit set */
+		if (chosen_special & (1 << i))
+		{
+			/* Add card to list */
+			used[n_used++] = special[i];
+		}
+	}
 
-		/* Check for better */
-		if (score_better(score, b_s))
+	/* Loop over chosen payment cards */
+	for (i = 0; (1 << i) <= chosen; i++)
+	{
+		/* Check for bit set */
+		if (chosen & (1 << i))
 		{
-			/* Track best */
-			b_s = score;
-			best = list[i];
+			/* Add card to list */
+			payment[num_payment++] = list[i];
 		}
 	}
 
-	/* Return best choice */
-	return best;
+	/* Take scratch game */
+	sim = push_sim();
+
+	/* Simulate game */
+	simulate_game(sim, g, who);
+
+	/* Attempt to pay */
+	if (!payment_callback(sim, who, which, payment, num_payment,
+	                      used, n_used, mil_only, mil_bonus))
+	{
+		/* Illegal payment */
+		pop_sim();
+		return;
+	}
+
+	/* Simulate most of rest of turn */
+	complete_turn(sim, COMPLETE_ROUND);
+
+	/* Evaluate result */
+	score = eval_game(sim, who);
+
+	/* Release scratch game */
+	pop_sim();
+
+	/* Check for better */
+	if (score_better(score, *b_s))
+	{
+		/* Save best */
+		*b_s = score;
+		*best = chosen;
+		*best_special = chosen_special;
+	}
 }
 
 /*
@@ -5776,64 +6314,16 @@ static void ai_choose_pay_aux2(game *g, int who, int which, int list[],
                                int chosen_special, int *best, int *best_special,
                                double *b_s)
 {
-	game sim;
-	int payment[MAX_DECK], num_payment = 0, used[MAX_DECK], n_used = 0;
-	double score;
-	int i;
-
 	/* Check for too few choices */
 	if (c > n) return;
 
 	/* Check for no more cards to try */
 	if (!n)
 	{
-		/* Loop over chosen special cards */
-		for (i = 0; i < num_special; i++)
-		{
-			/* Check for bit set */
-			if (chosen_special & (1 << i))
-			{
-				/* Add card to list */
-				used[n_used++] = special[i];
-			}
-		}
-
-		/* Loop over chosen payment cards */
-		for (i = 0; (1 << i) <= chosen; i++)
-		{
-			/* Check for bit set */
-			if (chosen & (1 << i))
-			{
-				/* Add card to list */
-				payment[num_payment++] = list[i];
-			}
-		}
-
-		/* Simulate game */
-		simulate_game(&sim, g, who);
-
-		/* Attempt to pay */
-		if (!payment_callback(&sim, who, which, payment, num_payment,
-		                      used, n_used, mil_only, mil_bonus))
-		{
-			/* Illegal payment */
-			return;
-		}
-
-		/* Simulate most of rest of turn */
-		complete_turn(&sim, COMPLETE_ROUND);
-
-		/* Evaluate result */
-		score = eval_game(&sim, who);
-
-		/* Check for better */
-		if (score_better(score, *b_s))
-		{
-			/* Save best */
-			*b_s = score;
-			*best = chosen;
-			*best_special = chosen_special;
-		}
+		/* Score chosen payment */
+		try_payment(g, who, which, list, special, num_special,
+		            mil_only, mil_bonus, chosen, chosen_special,
+		            best, best_special, b_s);
 
 		/* Done */
 		return;
@@ -5870,17 +6360,50 @@ static struct legal_payment payment_list[100];
 int num_legal_payment;
 
 /*
- * Helper function for "ai_choose_pay" below.
+ * Cached set of legal special ability combinations for a payment.
+ */
+typedef struct payment_cache
+{
+	/* Hash value of payment situation */
+	uint64_t key;
+
+	/* Paying player, card played and phase, checked against the key */
+	int8_t who;
+	int16_t which;
+	int8_t cur_action;
+
+	/* Entry has been filled in */
+	int valid;
+
+	/* Legal combinations, and number of hand cards each needs */
+	struct legal_payment legal[100];
+	int num_legal;
+
+} payment_cache;
+
+/*
+ * Number of entries in payment cache (must be a power of two).
+ */
+#define PAYMENT_CACHE_SIZE 1024
+
+/*
+ * Table of cached payment combinations.
+ *
+ * Entries are replaced when another situation hashes to the same slot.
+ */
+static payment_cache payment_hash[PAYMENT_CACHE_SIZE];
+
+/*
+ * Helper function for "lookup_payment" below.
  *
  * Here we try different combinations of special abilities to pay for a
- * played card.
+ * played card, and add the legal ones to the cache entry.
  */
-static void ai_choose_pay_aux1(game *g, int who, int which, int list[], int num,
-                               int special[], int num_special, int mil_only,
-                               int mil_bonus, int next, int chosen_special,
-                               int *best, int *best_special, double *b_s)
+static void lookup_payment_aux(game *g, int who, int which, int special[],
+                               int num_special, int mil_only, int mil_bonus,
+                               int next, int chosen_special,
+                               payment_cache *p_ptr)
 {
-	game sim;
 	int used[MAX_DECK], n_used = 0;
 	int i, need;
 
@@ -5905,96 +6428,241 @@ static void ai_choose_pay_aux1(game *g, int who, int which, int list[], int num,
 		/* Check for illegal combination */
 		if (need < 0) return;
 
-		/* Check for more cards needed than available */
-		if (need > num) return;
+		/* Check for full list */
+		if (p_ptr->num_legal == 100) return;
 
-		/* Check for simulated game */
-		if (g->simulation)
-		{
-			/* Add payment to list */
-			payment_list[num_legal_payment].chosen_special =
-				chosen_special;
-			payment_list[num_legal_payment].needed = need;
-			num_legal_payment++;
+		/* Add combination to list */
+		p_ptr->legal[p_ptr->num_legal].chosen_special = chosen_special;
+		p_ptr->legal[p_ptr->num_legal].needed = need;
+		p_ptr->num_legal++;
 
-#if 0
-			/* Simulate game */
-			simulate_game(&sim, g, who);
+		/* Done */
+		return;
+	}
 
-			/* Attempt to pay */
-			if (!payment_callback(&sim, who, which, payment, need,
-			                      used, n_used, mil_only))
-			{
-				/* Error */
-				printf("Payment failed!\n");
-				abort();
-			}
+	/* Try without current ability */
+	lookup_payment_aux(g, who, which, special, num_special, mil_only,
+	                   mil_bonus, next + 1, chosen_special, p_ptr);
 
-			/* Simulate rest of current phase only */
-			complete_turn(&sim, COMPLETE_PHASE);
+	/* Try with current ability */
+	lookup_payment_aux(g, who, which, special, num_special, mil_only,
+	                   mil_bonus, next + 1, chosen_special | (1 << next),
+	                   p_ptr);
+}
 
-			/* Evaluate result */
-			score = eval_game(&sim, who);
+/*
+ * Look up the legal combinations of special abilities that may be used
+ * to pay for a played card, and the number of hand cards each needs.
+ *
+ * The answer depends only on the player's tableau, goods and chosen
+ * actions, so it is remembered for the many simulated games in which
+ * the same situation recurs.
+ */
+static payment_cache *lookup_payment(game *g, int who, int which,
+                                     int special[], int num_special,
+                                     int mil_only, int mil_bonus)
+{
+	player *p_ptr;
+	card *c_ptr;
+	payment_cache *e_ptr;
+	uint64_t key;
+	int value[4 * MAX_DECK];
+	int len = 0;
+	int i, x;
 
-			/* Check for better */
-			if (score_better(score, *b_s))
-			{
-				/* Save best */
-				*b_s = score;
-				*best = (1 << need) - 1;
-				*best_special = chosen_special;
-			}
-#endif
+	/* Get player pointer */
+	p_ptr = &g->p[who];
 
-			/* Done with simulated game */
-			return;
+	/* Get card being played */
+	c_ptr = &g->deck[which];
+
+	/* Add paying player and card being played to value */
+	value[len++] = who;
+	value[len++] = which;
+	value[len++] = c_ptr->d_ptr->index;
+	value[len++] = c_ptr->owner;
+
+	/* Add current phase and player's actions to value */
+	value[len++] = g->cur_action;
+	value[len++] = p_ptr->action[0];
+	value[len++] = p_ptr->action[1];
+
+	/* Add bonuses from earlier in the phase to value */
+	value[len++] = p_ptr->bonus_military;
+	value[len++] = p_ptr->bonus_reduce;
+
+	/* Add payment restrictions to value */
+	value[len++] = mil_only;
+	value[len++] = mil_bonus;
+
+	/* Add special cards to value */
+	value[len++] = num_special;
+	for (i = 0; i < num_special; i++)
+	{
+		/* Add card and its design */
+		value[len++] = special[i];
+		value[len++] = g->deck[special[i]].d_ptr->index;
+	}
+
+	/* Start at first card active at start of phase */
+	x = p_ptr->start_head[WHERE_ACTIVE];
+
+	/* Loop over cards (whose powers may be used) */
+	for ( ; x != -1; x = g->deck[x].start_next)
+	{
+		/* Add card, its design, location and used powers to value */
+		value[len++] = x;
+		value[len++] = g->deck[x].d_ptr->index;
+		value[len++] = g->deck[x].where;
+		value[len++] = g->deck[x].misc;
+	}
+
+	/* Separate lists */
+	value[len++] = -1;
+
+	/* Start at first active card */
+	x = p_ptr->head[WHERE_ACTIVE];
+
+	/* Loop over cards (counted for military and holding goods) */
+	for ( ; x != -1; x = g->deck[x].next)
+	{
+		/* Add card, its design, goods and unpaid flag to value */
+		value[len++] = x;
+		value[len++] = g->deck[x].d_ptr->index;
+		value[len++] = g->deck[x].num_goods;
+		value[len++] = g->deck[x].misc & MISC_UNPAID;
+	}
+
+	/* Get key for value */
+	key = gen_hash((unsigned char *)value, len * sizeof(int));
+
+	/* Get cache slot */
+	e_ptr = &payment_hash[key & (PAYMENT_CACHE_SIZE - 1)];
+
+	/* Check for match */
+	if (e_ptr->valid && e_ptr->key == key && e_ptr->who == who &&
+	    e_ptr->which == which && e_ptr->cur_action == g->cur_action)
+	{
+		/* Return entry */
+		return e_ptr;
+	}
+
+	/* Set key of entry */
+	e_ptr->key = key;
+	e_ptr->who = who;
+	e_ptr->which = which;
+	e_ptr->cur_action = g->cur_action;
+
+	/* Clear legal combinations */
+	e_ptr->num_legal = 0;
+
+	/* Find legal combinations */
+	lookup_payment_aux(g, who, which, special, num_special, mil_only,
+	                   mil_bonus, 0, 0, e_ptr);
+
+	/* Mark entry as filled in */
+	e_ptr->valid = 1;
+
+	/* Return entry */
+	return e_ptr;
+}
+
+/*
+ * Helper function for "ai_choose_pay" below.
+ *
+ * Here we try the legal combinations of special abilities to pay for a
+ * played card.
+ */
+static void ai_choose_pay_aux1(game *g, int who, int which, int list[], int num,
+                               int special[], int num_special, int mil_only,
+                               int mil_bonus, int *best, int *best_special,
+                               double *b_s)
+{
+	game sim;
+	payment_cache *e_ptr;
+	struct legal_payment legal[100];
+	int i, j, need, num_legal, sim_ready = 0;
+
+	/* Look up legal combinations of special abilities */
+	e_ptr = lookup_payment(g, who, which, special, num_special, mil_only,
+	                       mil_bonus);
+
+	/* Check for simulated game */
+	if (g->simulation)
+	{
+		/* Loop over legal combinations */
+		for (i = 0; i < e_ptr->num_legal; i++)
+		{
+			/* Check for more cards needed than available */
+			if (e_ptr->legal[i].needed > num) continue;
+
+			/* Add payment to list */
+			payment_list[num_legal_payment++] = e_ptr->legal[i];
 		}
 
-		/* Simulate game */
-		simulate_game(&sim, g, who);
+		/* Done */
+		return;
+	}
+
+	/*
+	 * Copy legal combinations.
+	 *
+	 * The cache entry may be replaced by payments in the simulated
+	 * games below.
+	 */
+	num_legal = e_ptr->num_legal;
+	memcpy(legal, e_ptr->legal, sizeof(struct legal_payment) * num_legal);
+
+	/* Loop over legal combinations */
+	for (i = 0; i < num_legal; i++)
+	{
+		/* Get cards needed */
+		need = legal[i].needed;
+
+		/* Check for more cards needed than available */
+		if (need > num) continue;
 
-		/* Loop over players who have not yet paid */
-		for (i = who + 1; i < g->num_players; i++)
+		/* Check for other players' payments not yet simulated */
+		if (!sim_ready)
 		{
-			/* Check for no placement */
-			if (g->p[i].placing == -1) continue;
+			/* Simulate game */
+			simulate_game(&sim, g, who);
 
-			/* Check for develop phase */
-			if (g->deck[which].d_ptr->type == TYPE_DEVELOPMENT)
-			{
-				/* Ask for development payment */
-				develop_action(&sim, i, g->p[i].placing);
-			}
-			else
+			/* Loop over players who have not yet paid */
+			for (j = who + 1; j < g->num_players; j++)
 			{
-				/* Ask for settle payment */
-				settle_finish(&sim, i, g->p[i].placing, 0, -1,
-					      0);
+				/* Check for no placement */
+				if (g->p[j].placing == -1) continue;
+
+				/* Check for develop phase */
+				if (g->deck[which].d_ptr->type ==
+				    TYPE_DEVELOPMENT)
+				{
+					/* Ask for development payment */
+					develop_action(&sim, j,
+					               g->p[j].placing);
+				}
+				else
+				{
+					/* Ask for settle payment */
+					settle_finish(&sim, j, g->p[j].placing,
+					              0, -1, 0);
 
-				/* Ask about future settle powers */
-				settle_extra(&sim, i, g->p[i].placing);
+					/* Ask about future settle powers */
+					settle_extra(&sim, j, g->p[j].placing);
+				}
 			}
+
+			/* Simulated game is ready */
+			sim_ready = 1;
 		}
 
 		/* Try payment with different card combinations */
 		ai_choose_pay_aux2(&sim, who, which, list, special, num_special,
-				   mil_only, mil_bonus, num, need, 0,
-		                   chosen_special, best, best_special, b_s);
-
-		/* Done */
-		return;
+		                   mil_only, mil_bonus, num, need, 0,
+		                   legal[i].chosen_special, best,
+		                   best_special, b_s);
 	}
-
-	/* Try without current ability */
-	ai_choose_pay_aux1(g, who, which, list, num, special, num_special,
-	                   mil_only, mil_bonus, next + 1, chosen_special, best,
-	                   best_special, b_s);
-
-	/* Try with current ability */
-	ai_choose_pay_aux1(g, who, which, list, num, special, num_special,
-	                   mil_only, mil_bonus, next + 1,
-	                   chosen_special | (1 << next), best, best_special,
-	                   b_s);
 }
 
 /*
@@ -6018,8 +6686,7 @@ static void ai_choose_pay(game *g, int who, int which, int list[], int *num,
 
 	/* Find best set of special abilities */
 	ai_choose_pay_aux1(g, who, which, list, *num, special, *num_special,
-	                   mil_only, mil_bonus, 0, 0, &best, &best_special,
-	                   &b_s);
+	                   mil_only, mil_bonus, &best, &best_special, &b_s);
 
 	/* Check for only one payment strategy */
 	if (b_s == -1 && num_legal_payment == 1)
@@ -6030,6 +6697,26 @@ static void ai_choose_pay(game *g, int who, int which, int list[], int *num,
 		best = (1 << payment_list[0].needed) - 1;
 	}
 
+	/* Check for multiple payment strategies in a playout */
+	if (b_s == -1 && num_legal_payment > 0 && in_playout(g, who))
+	{
+		/* Start with first strategy */
+		j = 0;
+
+		/* Find strategy needing fewest cards */
+		for (i = 1; i < num_legal_payment; i++)
+		{
+			/* Check for fewer cards */
+			if (payment_list[i].needed < payment_list[j].needed)
+				j = i;
+		}
+
+		/* Set payment */
+		b_s = 0;
+		best_special = payment_list[j].chosen_special;
+		best = (1 << payment_list[j].needed) - 1;
+	}
+
 	/* Check for multiple payment strategies */
 	if (b_s == -1 && num_legal_payment > 0)
 	{
@@ -6781,8 +7468,8 @@ static void ai_choose_trade(game *g, int who, int list[], int *num,
 		/* Try trading this good */
 		trade_chosen(&sim, who, list[i], no_bonus);
 
-		/* Check for simulated opponent's turn */
-		if (g->simulation && g->sim_who != who)
+		/* Check for simulated opponent's turn or playout */
+		if (quick_choice(g, who))
 		{
 			/* Score based on cards received */
 			score = sim.p[who].fake_hand;
@@ -6935,8 +7622,8 @@ static void ai_choose_consume(game *g, int who, int cidx[], int oidx[],
 		}
 	}
 
-	/* Check for simulated opponent's turn */
-	if (g->simulation && who != g->sim_who)
+	/* Check for simulated opponent's turn or playout */
+	if (quick_choice(g, who))
 	{
 		/* Loop over choices */
 		for (i = 0; i < *num; i++)
@@ -7213,23 +7900,77 @@ static void ai_choose_consume(game *g, int who, int cidx[], int oidx[],
 		}
 	}
 
-	/* Check for no power */
-	if (best == -1)
+	/* Check for no power */
+	if (best == -1)
+	{
+		if (!optional)
+		{
+			display_error("Selected no power, but some are mandatory!\n");
+			abort();
+		}
+		/* Select nothing */
+		*num = 0;
+		return;
+	}
+
+	/* Select best option */
+	cidx[0] = cidx[best];
+	oidx[0] = oidx[best];
+	*num = 1;
+}
+
+/*
+ * Score one set of chosen cards for ai_choose_consume_hand_aux().
+ */
+static void try_consume_hand_set(game *g, int who, int c_idx, int o_idx,
+                                 int list[], int chosen, int *best,
+                                 double *b_s)
+{
+	game *sim;
+	double score;
+	int discards[MAX_DECK], num_discards = 0;
+	int i;
+
+	/* Loop over chosen cards */
+	for (i = 0; (1 << i) <= chosen; i++)
+	{
+		/* Check for bit set */
+		if (chosen & (1 << i))
+		{
+			/* Add card to list */
+			discards[num_discards++] = list[i];
+		}
+	}
+
+	/* Take scratch game */
+	sim = push_sim();
+
+	/* Copy game */
+	simulate_game(sim, g, who);
+
+	/* Apply choice */
+	consume_hand_chosen(sim, who, c_idx, o_idx,
+	                    discards, num_discards);
+
+	/* Use remaining consume powers */
+	while (consume_action(sim, who));
+
+	/* Simulate rest of turn */
+	complete_turn(sim, COMPLETE_ROUND);
+
+	/* Evaluate result */
+	score = eval_game(sim, who);
+
+	/* Check for better score */
+	if (score_better(score, *b_s))
 	{
-		if (!optional)
-		{
-			display_error("Selected no power, but some are mandatory!\n");
-			abort();
-		}
-		/* Select nothing */
-		*num = 0;
-		return;
+		/* Save better choice */
+		*b_s = score;
+		*best = chosen;
 	}
 
-	/* Select best option */
-	cidx[0] = cidx[best];
-	oidx[0] = oidx[best];
-	*num = 1;
+	/* Release scratch game */
+	pop_sim();
 }
 
 /*
@@ -7239,51 +7980,15 @@ static void ai_choose_consume_hand_aux(game *g, int who, int c_idx, int o_idx,
                                        int list[], int n, int c, int chosen,
                                        int *best, double *b_s)
 {
-	game sim;
-	double score;
-	int discards[MAX_DECK], num_discards = 0;
-	int i;
-
 	/* Check for too few choices */
 	if (c > n) return;
 
 	/* Check for end */
 	if (!n)
 	{
-		/* Loop over chosen cards */
-		for (i = 0; (1 << i) <= chosen; i++)
-		{
-			/* Check for bit set */
-			if (chosen & (1 << i))
-			{
-				/* Add card to list */
-				discards[num_discards++] = list[i];
-			}
-		}
-
-		/* Copy game */
-		simulate_game(&sim, g, who);
-
-		/* Apply choice */
-		consume_hand_chosen(&sim, who, c_idx, o_idx,
-		                    discards, num_discards);
-
-		/* Use remaining consume powers */
-		while (consume_action(&sim, who));
-
-		/* Simulate rest of turn */
-		complete_turn(&sim, COMPLETE_ROUND);
-
-		/* Evaluate result */
-		score = eval_game(&sim, who);
-
-		/* Check for better score */
-		if (score_better(score, *b_s))
-		{
-			/* Save better choice */
-			*b_s = score;
-			*best = chosen;
-		}
+		/* Score chosen set */
+		try_consume_hand_set(g, who, c_idx, o_idx, list, chosen,
+		                     best, b_s);
 
 		/* Done */
 		return;
@@ -7408,54 +8113,71 @@ static void ai_choose_consume_hand(game *g, int who, int c_idx, int o_idx,
 }
 
 /*
- * Helper function for ai_choose_good().
+ * Score one set of chosen goods for ai_choose_good_aux().
  */
-static void ai_choose_good_aux(game *g, int who, int list[], int n, int c,
-                               int chosen, int c_idx, int o_idx,
-                               int *best, double *b_s)
+static void try_good_set(game *g, int who, int list[], int chosen, int c_idx,
+                         int o_idx, int *best, double *b_s)
 {
-	game sim;
+	game *sim;
 	double score;
 	int consume[MAX_DECK], num_consume = 0;
 	int i;
 
-	/* Check for too few choices */
-	if (c > n) return;
-
-	/* Check for end */
-	if (!n)
+	/* Loop over chosen cards */
+	for (i = 0; (1 << i) <= chosen; i++)
 	{
-		/* Loop over chosen cards */
-		for (i = 0; (1 << i) <= chosen; i++)
+		/* Check for bit set */
+		if (chosen & (1 << i))
 		{
-			/* Check for bit set */
-			if (chosen & (1 << i))
-			{
-				/* Add card to list */
-				consume[num_consume++] = list[i];
-			}
+			/* Add card to list */
+			consume[num_consume++] = list[i];
 		}
+	}
 
-		/* Copy game */
-		simulate_game(&sim, g, who);
+	/* Take scratch game */
+	sim = push_sim();
 
-		/* Apply choice */
-		if (!good_chosen(&sim, who, c_idx, o_idx, consume, num_consume))
-		{
-			/* Illegal choice */
-			return;
-		}
+	/* Copy game */
+	simulate_game(sim, g, who);
 
-		/* Evaluate result */
-		score = eval_game(&sim, who);
+	/* Apply choice */
+	if (!good_chosen(sim, who, c_idx, o_idx, consume, num_consume))
+	{
+		/* Illegal choice */
+		pop_sim();
+		return;
+	}
 
-		/* Check for better score */
-		if (score_better(score, *b_s))
-		{
-			/* Save better choice */
-			*b_s = score;
-			*best = chosen;
-		}
+	/* Evaluate result */
+	score = eval_game(sim, who);
+
+	/* Check for better score */
+	if (score_better(score, *b_s))
+	{
+		/* Save better choice */
+		*b_s = score;
+		*best = chosen;
+	}
+
+	/* Release scratch game */
+	pop_sim();
+}
+
+/*
+ * Helper function for ai_choose_good().
+ */
+static void ai_choose_good_aux(game *g, int who, int list[], int n, int c,
+                               int chosen, int c_idx, int o_idx,
+                               int *best, double *b_s)
+{
+	/* Check for too few choices */
+	if (c > n) return;
+
+	/* Check for end */
+	if (!n)
+	{
+		/* Score chosen set */
+		try_good_set(g, who, list, chosen, c_idx, o_idx, best, b_s);
 
 		/* Done */
 		return;
@@ -7481,8 +8203,8 @@ static void ai_choose_good(game *g, int who, int c_idx, int o_idx,
 	int c, n = 0;
 	int best, i;
 
-	/* Check for simulated game and opponent's turn */
-	if (g->simulation && who != g->sim_who)
+	/* Check for simulated opponent's turn or playout */
+	if (quick_choice(g, who))
 	{
 		/* Use first goods */
 		*num = max;
@@ -7779,6 +8501,14 @@ static void ai_choose_windfall(game *g, int who, int list[], int *num,
 		return;
 	}
 
+	/* Check for playout */
+	if (in_playout(g, who))
+	{
+		/* Use first world */
+		*num = 1;
+		return;
+	}
+
 	/* Loop over choices */
 	for (i = 0; i < *num; i++)
 	{
@@ -7830,6 +8560,21 @@ static void ai_choose_produce(game *g, int who, int cidx[], int oidx[], int num)
 	int i, best = -1;
 	double score, b_s = -1;
 
+	/* Check for playout */
+	if (in_playout(g, who))
+	{
+		/* Find first power on a card */
+		for (i = 0; i < num; i++) if (cidx[i] >= 0) break;
+
+		/* Use first choice if none found */
+		if (i == num) i = 0;
+
+		/* Select power */
+		cidx[0] = cidx[i];
+		oidx[0] = oidx[i];
+		return;
+	}
+
 	/* Loop over choices */
 	for (i = 0; i < num; i++)
 	{
@@ -8564,6 +9309,9 @@ static void ai_game_over(game *g, int who)
 	/* Perform final training */
 	perform_training(g, who, result);
 
+	/* Record positions and result for offline training */
+	if (ai_record) write_samples(&eval, ai_record, who, result);
+
 	/* Check for training done for all players */
 	if (who == g->num_players - 1)
 	{
@@ -8626,6 +9374,248 @@ decisions ai_func =
 	NULL,
 };
 
+/*
+ * Set of AI functions used in playouts.
+ *
+ * These are the usual functions, but choices check for this table and
+ * use cheap rules instead of searching.  No explore samples are taken.
+ */
+static decisions playout_func =
+{
+	ai_initialize,
+	ai_notify_rotation,
+	NULL,
+	ai_make_choice,
+	NULL,
+	NULL,
+	ai_game_over,
+	ai_shutdown,
+	NULL,
+};
+
+/*
+ * Choose actions for a player in a playout.
+ *
+ * Actions are scored from the hand size, goods and empty production
+ * worlds of the player, without looking at the role network (whose
+ * inputs need a simulated round per action).
+ */
+static void playout_choose_action(game *g, int who, int action[2])
+{
+	player *p_ptr;
+	card *c_ptr;
+	int score[MAX_ACTION];
+	int hand, goods, empty = 0;
+	int i, x, best;
+
+	/* Get player pointer */
+	p_ptr = &g->p[who];
+
+	/* Count cards believed to be in hand */
+	hand = count_player_area(g, who, WHERE_HAND) + p_ptr->fake_hand -
+	       p_ptr->fake_discards;
+
+	/* Count goods */
+	goods = count_player_area(g, who, WHERE_GOOD);
+
+	/* Start at first active card */
+	x = p_ptr->head[WHERE_ACTIVE];
+
+	/* Loop over active cards */
+	for ( ; x != -1; x = g->deck[x].next)
+	{
+		/* Get card pointer */
+		c_ptr = &g->deck[x];
+
+		/* Skip cards without production */
+		if (!c_ptr->d_ptr->good_type) continue;
+		if (c_ptr->d_ptr->flags & (FLAG_WINDFALL | FLAG_NO_PRODUCE))
+			continue;
+
+		/* Count production worlds without goods */
+		if (!c_ptr->num_goods) empty++;
+	}
+
+	/* Do not choose actions without a score */
+	for (i = 0; i < MAX_ACTION; i++) score[i] = -1;
+
+	/* Explore when short of cards */
+	score[ACT_EXPLORE_5_0] = hand < 4 ? 6 - hand : 1;
+
+	/* Develop and settle with cards to pay */
+	score[ACT_DEVELOP] = hand / 2;
+	score[ACT_SETTLE] = (hand + 1) / 2;
+
+	/* Consume for VP with several goods */
+	score[ACT_CONSUME_X2] = goods >= 2 ? 2 * goods : 0;
+
+	/* Trade when short of cards */
+	score[ACT_CONSUME_TRADE] = goods ? goods + (hand < 3 ? 2 : 0) : 0;
+
+	/* Produce on empty worlds */
+	score[ACT_PRODUCE] = 2 * empty;
+
+	/* Loop over actions to choose */
+	for (i = 0; i < 2; i++)
+	{
+		/* Assume first action is best */
+		best = 0;
+
+		/* Loop over actions */
+		for (x = 1; x < MAX_ACTION; x++)
+		{
+			/* Check for better score */
+			if (score[x] > score[best]) best = x;
+		}
+
+		/* Choose action */
+		action[i] = best;
+
+		/* Do not choose action again */
+		score[best] = -1;
+
+		/* Choose only one action in basic game */
+		if (!g->advanced)
+		{
+			/* No second action */
+			action[1] = -1;
+			break;
+		}
+	}
+}
+
+/*
+ * Play a simulated copy of the game to its end with the playout policy.
+ *
+ * Each round the players' actions are chosen by playout_choose_action(),
+ * and every other choice uses the cheap rules selected by in_playout().
+ * The result for each player is stored as in ai_game_over(), starting
+ * with the given player, so it may be used as a training target.  The
+ * given player's result is returned.
+ */
+double ai_playout(game *g, int who, double result[MAX_PLAYER])
+{
+	game *sim;
+	player *p_ptr;
+	int start[MAX_PLAYER], scores[MAX_PLAYER];
+	double sum = 0.0;
+	int i, n, max = 0;
+
+	/* Take scratch game */
+	sim = push_sim();
+
+	/* Copy game */
+	simulate_game(sim, g, who);
+
+	/* Loop over players */
+	for (i = 0; i < sim->num_players; i++)
+	{
+		/* Use playout functions */
+		sim->p[i].control = &playout_func;
+
+		/* Remember end of choice log */
+		start[i] = sim->p[i].choice_size;
+	}
+
+	/* Finish current round if needed */
+	if (sim->cur_action != ACT_ROUND_START &&
+	    sim->cur_action != ACT_ROUND_END)
+	{
+		/* Complete round */
+		complete_turn(sim, COMPLETE_ROUND);
+	}
+
+	/* Play rounds until game is over */
+	while (!sim->game_over)
+	{
+		/* Clear selected phases */
+		for (i = 0; i < MAX_ACTION; i++) sim->action_selected[i] = 0;
+
+		/* Loop over players */
+		for (i = 0; i < sim->num_players; i++)
+		{
+			/* Choose actions */
+			playout_choose_action(sim, i, sim->p[i].action);
+		}
+
+		/* Note actions */
+		note_actions(sim);
+
+		/* Start next round */
+		sim->round++;
+		sim->cur_action = ACT_ROUND_START;
+
+		/* Play round */
+		complete_turn(sim, COMPLETE_ROUND);
+
+		/* Loop over players */
+		for (i = 0; i < sim->num_players; i++)
+		{
+			/* Get player pointer */
+			p_ptr = &sim->p[i];
+
+			/* Forget choices made this round */
+			p_ptr->choice_size = p_ptr->choice_pos = start[i];
+
+			/* Copy actions to previous */
+			p_ptr->prev_action[0] = p_ptr->action[0];
+			p_ptr->prev_action[1] = p_ptr->action[1];
+		}
+
+		/* Check for too many rounds */
+		if (sim->round >= 30) sim->game_over = 1;
+	}
+
+	/* Score game */
+	score_game(sim);
+
+	/* Determine winner */
+	declare_winner(sim);
+
+	/* Find maximum score */
+	for (i = 0; i < sim->num_players; i++)
+	{
+		/* Get player pointer */
+		p_ptr = &sim->p[i];
+
+		/* Copy score */
+		scores[i] = p_ptr->end_vp;
+
+		/* Give extra reward to winner */
+		if (p_ptr->winner) scores[i]++;
+
+		/* Check for more */
+		if (scores[i] > max) max = scores[i];
+	}
+
+	/* Compute probability sum */
+	for (i = 0; i < sim->num_players; i++)
+	{
+		/* Add this player's portion */
+		sum += exp(0.3 * (scores[i] - max));
+	}
+
+	/* Compute given player's result first */
+	result[0] = exp(0.3 * (scores[who] - max)) / sum;
+
+	/* Start other players at slot 1 */
+	n = 1;
+
+	/* Loop over other players in order */
+	for (i = (who + 1) % sim->num_players; i != who;
+	     i = (i + 1) % sim->num_players)
+	{
+		/* Compute result */
+		result[n++] = exp(0.3 * (scores[i] - max)) / sum;
+	}
+
+	/* Release scratch game */
+	pop_sim();
+
+	/* Return given player's result */
+	return result[0];
+}
+
 /*
  * Provide debugging information.
  */
@@ -8847,6 +9837,8 @@ static void initial_training(game *g)
 	g->deck_size = 0;
 	g->cur_action = 0;
 	memset(g->deck, 0, sizeof(card) * MAX_DECK);
+	rebuild_piles(g);
+	g->power_version = 1;
 	memset(g->goal_active, 0, sizeof(int) * MAX_GOAL);
 	memset(g->goal_avail, 0, sizeof(int) * MAX_GOAL);
 
@@ -8866,6 +9858,7 @@ static void initial_training(game *g)
 		/* Clear player's card stacks */
 		for (j = 0; j < MAX_WHERE; j++) g->p[i].head[j] = -1;
 		for (j = 0; j < MAX_WHERE; j++) g->p[i].start_head[j] = -1;
+		clear_card_sets(&g->p[i]);
 	}
 
 	/* Perform several training iterations */
@@ -183,6 +183,9 @@ static void handle_status_card(char *ptr)
 	/* Read misc flags */
 	c_ptr->misc = get_integer(&ptr);
 
+	/* Used powers may have changed */
+	real_game.power_version++;
+
 	/* Read order played */
 	c_ptr->order = get_integer(&ptr);
 
@@ -340,6 +343,181 @@ static void handle_choose(char *ptr)
 	send_msg(0, msg);
 }
 
+/*
+ * Handle a choice request while preparing answers in advance.
+ *
+ * This function is called by the local rules engine while we simulate our
+ * part of the current phase.  We ask the AI for its decision and send the
+ * answer to the server, so that it is already waiting in our choice log
+ * when the server reaches the question.
+ */
+static void prepare_make_choice(game *g, int who, int type, int list[], int *nl,
+                                int special[], int *ns, int arg1, int arg2,
+                                int arg3)
+{
+	player *p_ptr = &g->p[who];
+	char msg[1024], *ptr = msg;
+	int i;
+
+	/* Check for random number generator used in prepared game */
+	if (g->random_seed != 0 || g->p[who].fake_hand > 0)
+	{
+		/* Abort preparation */
+		g->game_over = 1;
+		return;
+	}
+
+	/* Ask AI for decision */
+	ai_func.make_choice(g, who, type, list, nl, special, ns,
+	                    arg1, arg2, arg3);
+
+	/* Begin message */
+	start_msg(&ptr, MSG_CHOOSE);
+
+	/* Put choice log position */
+	put_integer(p_ptr->choice_pos, &ptr);
+
+	/* Copy entries from choice log */
+	for (i = p_ptr->choice_pos; i < p_ptr->choice_size; i++)
+	{
+		/* Copy entry */
+		put_integer(p_ptr->choice_log[i], &ptr);
+	}
+
+	/* Finish message */
+	finish_msg(msg, ptr);
+
+	/* Send to server */
+	send_msg(0, msg);
+}
+
+/*
+ * Control interface used only when preparing answers to predicted questions.
+ */
+static decisions prepare_func =
+{
+	NULL,
+	NULL,
+	NULL,
+	prepare_make_choice,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+};
+
+/*
+ * Server has asked us to prepare our answers for the given phase.
+ *
+ * We play out our own part of the phase on a copy of the game, answering
+ * each question as it comes up.  This lets the AI think while the other
+ * players are still making their decisions, instead of waiting until the
+ * server asks for each choice in turn.
+ */
+static void handle_prepare(char *ptr)
+{
+	game prep;
+	player *p_ptr = &real_game.p[player_us];
+	int pos, phase, arg, i;
+
+	/* Get position in choice log to fill */
+	pos = get_integer(&ptr);
+
+	/* Check for further along in log than we are */
+	if (pos > p_ptr->choice_pos)
+	{
+		/* Adjust current position */
+		p_ptr->choice_size = p_ptr->choice_pos = pos;
+	}
+
+	/* Check for request for choice we have already made */
+	else if (pos < p_ptr->choice_pos)
+	{
+		/* XXX Do nothing */
+		return;
+	}
+
+	/* Get phase and argument from message */
+	phase = get_integer(&ptr);
+	arg = get_integer(&ptr);
+
+	/* Copy game */
+	prep = real_game;
+
+	/*
+	 * Leave the copy marked as a real game, so that the AI gives the
+	 * same answers it would give when asked directly.
+	 */
+	prep.simulation = 0;
+
+	/* Clear random number generator information to detect use */
+	prep.random_seed = 0;
+
+	/* Loop over players */
+	for (i = 0; i < prep.num_players; i++)
+	{
+		/* Set AI control for any other player questioned */
+		prep.p[i].control = &ai_func;
+	}
+
+	/* Set our control interface to send answers to the server */
+	prep.p[player_us].control = &prepare_func;
+
+	/* Check phase */
+	switch (phase)
+	{
+		/* Develop */
+		case PHASE_DEVELOP:
+
+			/* Set our placing argument */
+			prep.p[player_us].placing = arg;
+
+			/* Perform develop action */
+			develop_action(&prep, player_us, arg);
+			break;
+
+		/* Settle */
+		case PHASE_SETTLE:
+
+			/* Set our placing argument */
+			prep.p[player_us].placing = arg;
+
+			/* Don't prepare for takeovers */
+			if (arg == -1) break;
+
+			/* Perform settle action */
+			settle_finish(&prep, player_us, arg, 0, -1, 0);
+			settle_extra(&prep, player_us, arg);
+			break;
+
+		/* Consume */
+		case PHASE_CONSUME:
+
+			/* Perform consume phase for ourself */
+			consume_player(&prep, player_us);
+			break;
+
+		/* Produce */
+		case PHASE_PRODUCE:
+
+			/* Perform produce phase for ourself */
+			produce_player(&prep, player_us);
+			break;
+	}
+
+	/* Copy prepared choice log position to real game */
+	p_ptr->choice_size = prep.p[player_us].choice_size;
+	p_ptr->choice_pos = prep.p[player_us].choice_pos;
+
+	/* Check for completed preparation */
+	if (!prep.game_over)
+	{
+		/* Tell server that we have finished */
+		send_msgf(0, MSG_PREPARE, "d", phase);
+	}
+}
+
 /*
  * A complete message has been read.
  */
@@ -405,6 +583,13 @@ static void message_read(char *data)
 			handle_choose(ptr);
 			break;
 
+		/* Prepare answers for phase */
+		case MSG_PREPARE:
+
+			/* Handle message */
+			handle_prepare(ptr);
+			break;
+
 		/* Game is over */
 		case MSG_GAMEOVER:
 
@@ -429,7 +614,6 @@ static void message_read(char *data)
 		case MSG_CHAT:
 		case MSG_GAMECHAT:
 		case MSG_WAITING:
-		case MSG_PREPARE:
 			break;
 
 		default:
@@ -0,0 +1,279 @@
+/*
+ * Race for the Galaxy AI
+ *
+ * Copyright (C) 2009-2011 Keldon Jones
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Benchmark for AI self-play.
+ *
+ * Plays a number of games between AI players and reports how many games
+ * and simulated games (rollouts) were played per second.  The networks
+ * are loaded but never trained or saved.
+ *
+ * With -P, a playout to the end of the game is also made from the start
+ * of every round, and the playouts are timed on their own.
+ *
+ * With -E, the games record an event log, to measure its cost.
+ *
+ * A build of the engine with message formatting compiled out was tried
+ * with this benchmark and dropped.  Simulated games already skip the
+ * formatting at run time, so it ran no faster, even for playouts that
+ * spend nearly all their time in the engine.
+ *
+ * Build with "make bench".
+ */
+
+#include "rftg.h"
+#include <time.h>
+
+/*
+ * Event log used with -E.
+ */
+static event_log bench_events;
+
+/*
+ * Print errors to standard output.
+ */
+void display_error(char *msg)
+{
+	/* Forward message */
+	printf("%s", msg);
+}
+
+/*
+ * Ignore messages.
+ */
+void message_add(game *g, char *msg)
+{
+}
+
+/*
+ * Ignore messages.
+ */
+void message_add_formatted(game *g, char *msg, char *tag)
+{
+}
+
+/*
+ * Use simple random number generator.
+ */
+int game_rand(game *g)
+{
+	/* Call simple random number generator */
+	return simple_rand(&g->random_seed);
+}
+
+/*
+ * Play a number of games and time them.
+ */
+int main(int argc, char *argv[])
+{
+	game my_game;
+	int i, j, n = 10;
+	int num_players = 3;
+	int expansion = 0, advanced = 0, playouts = 0, num_playout = 0;
+	int events = 0;
+	long num_event = 0;
+	char buf[1024];
+	clock_t start, play_start, play_time = 0;
+	double secs, result[MAX_PLAYER];
+
+	/* Use fixed random seed by default */
+	my_game.random_seed = 1;
+
+	/* Read card database */
+	if (read_cards(NULL) < 0)
+	{
+		/* Exit */
+		exit(1);
+	}
+
+	/* Parse arguments */
+	for (i = 1; i < argc; i++)
+	{
+		/* Check for number of players */
+		if (!strcmp(argv[i], "-p"))
+		{
+			/* Set number of players */
+			num_players = atoi(argv[++i]);
+		}
+
+		/* Check for advanced game */
+		else if (!strcmp(argv[i], "-a"))
+		{
+			/* Set advanced flag */
+			advanced = 1;
+		}
+
+		/* Check for expansion level */
+		else if (!strcmp(argv[i], "-e"))
+		{
+			/* Set expansion level */
+			expansion = atoi(argv[++i]);
+		}
+
+		/* Check for number of games */
+		else if (!strcmp(argv[i], "-n"))
+		{
+			/* Set number of games */
+			n = atoi(argv[++i]);
+		}
+
+		/* Check for random seed */
+		else if (!strcmp(argv[i], "-r"))
+		{
+			/* Set random seed */
+			my_game.random_seed = atoi(argv[++i]);
+		}
+
+		/* Check for playouts */
+		else if (!strcmp(argv[i], "-P"))
+		{
+			/* Time playouts */
+			playouts = 1;
+		}
+
+		/* Check for event log */
+		else if (!strcmp(argv[i], "-E"))
+		{
+			/* Record events */
+			events = 1;
+		}
+	}
+
+	/* Set game options */
+	my_game.num_players = num_players;
+	my_game.expanded = expansion;
+	my_game.advanced = advanced;
+	my_game.promo = 0;
+	my_game.goal_disabled = 0;
+	my_game.takeover_disabled = 0;
+	my_game.camp = NULL;
+
+	/* Call initialization functions */
+	for (i = 0; i < num_players; i++)
+	{
+		/* Create player name */
+		sprintf(buf, "Player %d", i);
+
+		/* Set player name */
+		my_game.p[i].name = strdup(buf);
+
+		/* Set player interfaces to AI functions */
+		my_game.p[i].control = &ai_func;
+
+		/* Initialize AI without learning */
+		my_game.p[i].control->init(&my_game, i, 0.0);
+
+		/* Create choice log for player */
+		my_game.p[i].choice_log = (int *)malloc(sizeof(int) * 4096);
+
+		/* Clear choice log size and position */
+		my_game.p[i].choice_size = 0;
+		my_game.p[i].choice_pos = 0;
+	}
+
+	/* Start timer */
+	start = clock();
+
+	/* Play a number of games */
+	for (i = 0; i < n; i++)
+	{
+		/* Initialize game */
+		init_game(&my_game);
+
+		/* Record events if asked */
+		if (events) start_events(&my_game, &bench_events);
+
+		/* Begin game */
+		begin_game(&my_game);
+
+		/* Play game rounds until finished */
+		while (game_round(&my_game))
+		{
+			/* Check for playouts */
+			if (!playouts) continue;
+
+			/* Start playout timer */
+			play_start = clock();
+
+			/* Play out rest of game */
+			ai_playout(&my_game, 0, result);
+
+			/* Count playout and its time */
+			play_time += clock() - play_start;
+			num_playout++;
+		}
+
+		/* Score game */
+		score_game(&my_game);
+
+		/* Declare winner */
+		declare_winner(&my_game);
+
+		/* Count events recorded */
+		if (events) num_event += bench_events.head;
+
+		/* Call player game over functions */
+		for (j = 0; j < num_players; j++)
+		{
+			/* Call game over function */
+			my_game.p[j].control->game_over(&my_game, j);
+
+			/* Clear choice log */
+			my_game.p[j].choice_size = 0;
+			my_game.p[j].choice_pos = 0;
+		}
+	}
+
+	/* Compute elapsed time */
+	secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	/* Avoid dividing by zero */
+	if (secs <= 0) secs = 0.001;
+
+	/* Print results */
+	printf("Played %d games in %.2f seconds\n", n, secs);
+	printf("Games per second: %.2f\n", n / secs);
+	printf("Rollouts per second: %.0f\n", ai_num_sim / secs);
+
+	/* Check for event log */
+	if (events)
+	{
+		/* Print events recorded */
+		printf("Events per game: %.0f\n", (double)num_event / n);
+	}
+
+	/* Check for playouts */
+	if (num_playout)
+	{
+		/* Get time spent in playouts */
+		secs = (double)play_time / CLOCKS_PER_SEC;
+
+		/* Avoid dividing by zero */
+		if (secs <= 0) secs = 0.001;
+
+		/* Print playout results */
+		printf("Made %d playouts in %.2f seconds\n", num_playout,
+		       secs);
+		printf("Playouts per second: %.0f\n", num_playout / secs);
+	}
+
+	/* Done */
+	return 0;
+}
@@ -701,6 +701,9 @@ static void handle_status_card(char *ptr, int size)
 	/* Read card flags */
 	c_ptr->misc = get_integer(&ptr);
 
+	/* Used powers may have changed */
+	real_game.power_version++;
+
 	/* Read order played */
 	c_ptr->order = get_integer(&ptr);
 
@@ -0,0 +1,356 @@
+/*
+ * Race for the Galaxy AI
+ *
+ * Copyright (C) 2009-2011 Keldon Jones
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Stand-in database for the server.
+ *
+ * Only the queries needed to log in and create games are answered: users
+ * are kept in memory, games are numbered, and a password "hash" is the
+ * password itself.  Every other query succeeds and returns no rows, so
+ * nothing is saved or restored across server runs.
+ *
+ * Build the server with it as "make server-stub".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dbstub.h"
+
+/*
+ * Maximum number of columns in a result.
+ */
+#define STUB_FIELDS 2
+
+/*
+ * Result of a query, holding at most one row.
+ */
+struct MYSQL_RES
+{
+	/* Columns of row */
+	char *field[STUB_FIELDS];
+
+	/* Lengths of columns */
+	unsigned long len[STUB_FIELDS];
+
+	/* Row is present */
+	int has_row;
+
+	/* Row has been fetched */
+	int fetched;
+};
+
+/*
+ * Database connection.
+ */
+struct MYSQL
+{
+	/* Result of last query */
+	MYSQL_RES *res;
+};
+
+/*
+ * The only connection.
+ */
+static MYSQL stub_db;
+
+/*
+ * Known users and their passwords.
+ *
+ * User IDs start at one.
+ */
+static char **user_name, **user_pass;
+static int num_user, max_user;
+
+/*
+ * Number of games created.
+ */
+static int num_game;
+
+/*
+ * Last ID assigned by an insertion.
+ */
+static int last_id;
+
+/*
+ * Create a result with no rows.
+ */
+static MYSQL_RES *new_result(void)
+{
+	/* Allocate cleared result */
+	return (MYSQL_RES *)calloc(1, sizeof(MYSQL_RES));
+}
+
+/*
+ * Add a column to a result's row.
+ */
+static void add_field(MYSQL_RES *res, int i, char *text)
+{
+	/* Copy column */
+	res->field[i] = strdup(text);
+	res->len[i] = strlen(text);
+
+	/* Result has a row */
+	res->has_row = 1;
+}
+
+/*
+ * Look up a user by name.
+ *
+ * Return the index of the user, or -1 if not found.
+ */
+static int find_user(char *name)
+{
+	int i;
+
+	/* Loop over users */
+	for (i = 0; i < num_user; i++)
+	{
+		/* Check for match */
+		if (!strcmp(user_name[i], name)) return i;
+	}
+
+	/* Not found */
+	return -1;
+}
+
+/*
+ * Add a user.
+ */
+static void add_user(char *name, char *pass)
+{
+	/* Check for full list */
+	if (num_user == max_user)
+	{
+		/* Grow lists */
+		max_user = 2 * max_user + 64;
+		user_name = (char **)realloc(user_name,
+		                             sizeof(char *) * max_user);
+		user_pass = (char **)realloc(user_pass,
+		                             sizeof(char *) * max_user);
+	}
+
+	/* Copy name and password */
+	user_name[num_user] = strdup(name);
+	user_pass[num_user] = strdup(pass);
+
+	/* Count user and remember ID */
+	last_id = ++num_user;
+}
+
+/*
+ * Return the connection.
+ */
+MYSQL *mysql_init(MYSQL *m)
+{
+	/* Use the only connection */
+	return &stub_db;
+}
+
+/*
+ * Pretend to connect.
+ */
+MYSQL *mysql_real_connect(MYSQL *m, const char *host, const char *user,
+                          const char *pass, const char *db,
+                          unsigned int port, const char *sock,
+                          unsigned long flags)
+{
+	/* Always succeed */
+	return m;
+}
+
+/*
+ * Ignore options.
+ */
+int mysql_options(MYSQL *m, int option, const void *arg)
+{
+	/* Success */
+	return 0;
+}
+
+/*
+ * There are never errors.
+ */
+const char *mysql_error(MYSQL *m)
+{
+	/* No error */
+	return "";
+}
+
+/*
+ * Escape quotes and backslashes in a string.
+ *
+ * Return the length of the escaped string.
+ */
+unsigned long mysql_real_escape_string(MYSQL *m, char *to, const char *from,
+                                       unsigned long len)
+{
+	char *start = to;
+	unsigned long i;
+
+	/* Loop over characters */
+	for (i = 0; i < len; i++)
+	{
+		/* Escape special characters */
+		if (from[i] == '\'' || from[i] == '\\') *to++ = '\\';
+
+		/* Copy character */
+		*to++ = from[i];
+	}
+
+	/* End string */
+	*to = '\0';
+
+	/* Return length */
+	return to - start;
+}
+
+/*
+ * Run a query.
+ */
+int mysql_query(MYSQL *m, const char *query)
+{
+	MYSQL_RES *res;
+	char name[1024], pass[1024], text[1024];
+	const char *ptr;
+	int x;
+
+	/* Discard unfetched result */
+	if (m->res) mysql_free_result(m->res);
+
+	/* Start with empty result */
+	m->res = res = new_result();
+
+	/* Check for user lookup */
+	if (sscanf(query, "SELECT pass, uid FROM users WHERE user='%1023[^']'",
+	           name) == 1)
+	{
+		/* Look for user */
+		x = find_user(name);
+
+		/* Check for found */
+		if (x >= 0)
+		{
+			/* Return password and ID */
+			sprintf(text, "%d", x + 1);
+			add_field(res, 0, user_pass[x]);
+			add_field(res, 1, text);
+		}
+	}
+
+	/* Check for user name lookup */
+	else if (sscanf(query, "SELECT user FROM users WHERE uid=%d", &x) == 1)
+	{
+		/* Check for known user */
+		if (x > 0 && x <= num_user) add_field(res, 0, user_name[x - 1]);
+	}
+
+	/* Check for password hash */
+	else if (sscanf(query, "SELECT SHA1('%1023[^']')", pass) == 1)
+	{
+		/* Return password as its own hash */
+		add_field(res, 0, pass);
+	}
+
+	/* Check for last inserted ID */
+	else if (!strcmp(query, "SELECT LAST_INSERT_ID()"))
+	{
+		/* Return ID */
+		sprintf(text, "%d", last_id);
+		add_field(res, 0, text);
+	}
+
+	/* Check for new user */
+	else if (!strncmp(query, "INSERT INTO users", 17))
+	{
+		/* Find values */
+		ptr = strstr(query, "VALUES");
+
+		/* Read name and password */
+		if (ptr && sscanf(ptr, "VALUES ('%1023[^']', SHA1('%1023[^']'))",
+		                  name, pass) == 2)
+		{
+			/* Add user */
+			add_user(name, pass);
+		}
+	}
+
+	/* Check for new game */
+	else if (!strncmp(query, "INSERT INTO games", 17))
+	{
+		/* Number game */
+		last_id = ++num_game;
+	}
+
+	/* Success */
+	return 0;
+}
+
+/*
+ * Return the result of the last query.
+ */
+MYSQL_RES *mysql_store_result(MYSQL *m)
+{
+	MYSQL_RES *res = m->res;
+
+	/* Result now belongs to caller */
+	m->res = NULL;
+
+	/* Return result, or an empty one */
+	return res ? res : new_result();
+}
+
+/*
+ * Return the next row of a result, or NULL when there are no more.
+ */
+MYSQL_ROW mysql_fetch_row(MYSQL_RES *res)
+{
+	/* Check for no more rows */
+	if (!res->has_row || res->fetched) return NULL;
+
+	/* Mark row as fetched */
+	res->fetched = 1;
+
+	/* Return columns */
+	return res->field;
+}
+
+/*
+ * Return the lengths of the columns of the last row fetched.
+ */
+unsigned long *mysql_fetch_lengths(MYSQL_RES *res)
+{
+	/* Return lengths */
+	return res->len;
+}
+
+/*
+ * Free a result.
+ */
+void mysql_free_result(MYSQL_RES *res)
+{
+	int i;
+
+	/* Loop over columns */
+	for (i = 0; i < STUB_FIELDS; i++) free(res->field[i]);
+
+	/* Free result */
+	free(res);
+}
@@ -0,0 +1,75 @@
+/*
+ * Race for the Galaxy AI
+ *
+ * Copyright (C) 2009-2011 Keldon Jones
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Stand-in for the parts of the MySQL client library used by the server.
+ *
+ * Building the server with -DSTUB_DB and dbstub.c gives a server that
+ * keeps users in memory and forgets everything else, for load testing
+ * without a database.
+ */
+#ifndef DBSTUB_H
+#define DBSTUB_H
+
+/*
+ * Database connection.
+ */
+typedef struct MYSQL MYSQL;
+
+/*
+ * Result of a query.
+ */
+typedef struct MYSQL_RES MYSQL_RES;
+
+/*
+ * One row of a result.
+ */
+typedef char **MYSQL_ROW;
+
+/*
+ * Boolean option value.
+ */
+typedef char my_bool;
+
+/*
+ * Connection options.
+ */
+#define MYSQL_OPT_RECONNECT 0
+
+/*
+ * Library functions.
+ */
+extern MYSQL *mysql_init(MYSQL *m);
+extern MYSQL *mysql_real_connect(MYSQL *m, const char *host,
+                                 const char *user, const char *pass,
+                                 const char *db, unsigned int port,
+                                 const char *sock, unsigned long flags);
+extern int mysql_options(MYSQL *m, int option, const void *arg);
+extern const char *mysql_error(MYSQL *m);
+extern unsigned long mysql_real_escape_string(MYSQL *m, char *to,
+                                              const char *from,
+                                              unsigned long len);
+extern int mysql_query(MYSQL *m, const char *query);
+extern MYSQL_RES *mysql_store_result(MYSQL *m);
+extern MYSQL_ROW mysql_fetch_row(MYSQL_RES *res);
+extern unsigned long *mysql_fetch_lengths(MYSQL_RES *res);
+extern void mysql_free_result(MYSQL_RES *res);
+
+#endif
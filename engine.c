@@ -22,6 +22,11 @@
 
 #include "rftg.h"
 
+/*
+ * Forward declaration.
+ */
+static int bonus_match(game *g, vp_bonus *v_ptr, design *d_ptr);
+
 /*
  * Expansion level names.
  */
@@ -143,6 +148,137 @@ int simple_rand(unsigned int *seed)
 	return ((unsigned)(*seed/65536) % 32768);
 }
 
+/*
+ * Return the next value of a SplitMix64 sequence.
+ *
+ * This is only used to spread a seed over the state of a stream.
+ */
+static uint64_t splitmix64(uint64_t *x)
+{
+	uint64_t z;
+
+	/* Advance sequence */
+	z = (*x += 0x9e3779b97f4a7c15ULL);
+
+	/* Mix bits */
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+/*
+ * Start a stream of random numbers.
+ *
+ * Streams with the same seed but different stream numbers are unrelated,
+ * so each sampler (or thread) can have its own reproducible stream.
+ */
+void rng_seed(rng_stream *r, uint64_t seed, uint64_t stream)
+{
+	uint64_t x, y;
+
+	/* Combine seed and stream number */
+	x = seed ^ splitmix64(&stream);
+
+	/* Fill state */
+	y = splitmix64(&x);
+	r->s[0] = (uint32_t)y;
+	r->s[1] = (uint32_t)(y >> 32);
+	y = splitmix64(&x);
+	r->s[2] = (uint32_t)y;
+	r->s[3] = (uint32_t)(y >> 32);
+
+	/* State must not be all zero */
+	if (!(r->s[0] | r->s[1] | r->s[2] | r->s[3])) r->s[0] = 1;
+}
+
+/*
+ * Return the next 32 random bits from a stream (xoshiro128**).
+ */
+uint32_t rng_next(rng_stream *r)
+{
+	uint32_t *s = r->s;
+	uint32_t x, t;
+
+	/* Compute result */
+	x = s[1] * 5;
+	x = ((x << 7) | (x >> 25)) * 9;
+
+	/* Advance state */
+	t = s[1] << 9;
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = (s[3] << 11) | (s[3] >> 21);
+
+	/* Return result */
+	return x;
+}
+
+/*
+ * Return a random number from 0 to n - 1, with every value equally likely.
+ */
+uint32_t rng_below(rng_stream *r, uint32_t n)
+{
+	uint64_t m;
+	uint32_t low, limit;
+
+	/* Scale random bits to range */
+	m = (uint64_t)rng_next(r) * n;
+	low = (uint32_t)m;
+
+	/* Check for value in the uneven part of the range */
+	if (low < n)
+	{
+		/* Compute number of values to reject */
+		limit = -n % n;
+
+		/* Draw again until an even value is found */
+		while (low < limit)
+		{
+			/* Scale new random bits */
+			m = (uint64_t)rng_next(r) * n;
+			low = (uint32_t)m;
+		}
+	}
+
+	/* Return high part */
+	return m >> 32;
+}
+
+/*
+ * Fill an array with random numbers from 0 to n - 1.
+ *
+ * The values are the same as calling rng_below() once for each entry.
+ */
+void rng_fill_below(rng_stream *r, uint32_t out[], int count, uint32_t n)
+{
+	uint64_t m;
+	uint32_t limit;
+	int i;
+
+	/* Compute number of values to reject */
+	limit = -n % n;
+
+	/* Loop over array */
+	for (i = 0; i < count; i++)
+	{
+		/* Scale random bits to range */
+		m = (uint64_t)rng_next(r) * n;
+
+		/* Draw again while value is in the uneven part of the range */
+		while ((uint32_t)m < limit)
+		{
+			/* Scale new random bits */
+			m = (uint64_t)rng_next(r) * n;
+		}
+
+		/* Store high part */
+		out[i] = m >> 32;
+	}
+}
+
 /*
  * Return whether goals are enabled in this game.
  */
@@ -160,21 +296,17 @@ int takeovers_enabled(game *g)
 }
 
 /*
- * Return the number of cards in the draw deck.
+ * Return the number of cards in a set.
  */
-static int count_draw(game *g)
+static int count_card_set(uint64_t *bits)
 {
-	card *c_ptr;
 	int i, n = 0;
 
-	/* Loop over cards */
-	for (i = 0; i < g->deck_size; i++)
+	/* Loop over words */
+	for (i = 0; i < CARD_WORDS; i++)
 	{
-		/* Get card pointer */
-		c_ptr = &g->deck[i];
-
-		/* Count cards in draw deck */
-		if (c_ptr->where == WHERE_DECK) n++;
+		/* Count cards in word */
+		n += __builtin_popcountll(bits[i]);
 	}
 
 	/* Return count */
@@ -182,25 +314,120 @@ static int count_draw(game *g)
 }
 
 /*
- * Return whether the draw deck is empty.
+ * Change a card's location, keeping track of the draw and discard piles.
  */
-static int draw_empty(game *g)
+static void set_where(game *g, int which, int where)
+{
+	card *c_ptr;
+	uint64_t bit;
+
+	/* Get card pointer */
+	c_ptr = &g->deck[which];
+
+	/* Get card's bit */
+	bit = 1ULL << (which % 64);
+
+	/* Remove card from old pile */
+	if (c_ptr->where == WHERE_DECK)
+	{
+		/* Remove from draw pile */
+		g->draw_bits[which / 64] &= ~bit;
+		g->num_draw--;
+	}
+	else if (c_ptr->where == WHERE_DISCARD)
+	{
+		/* Remove from discard pile */
+		g->discard_bits[which / 64] &= ~bit;
+	}
+
+	/* Add card to new pile */
+	if (where == WHERE_DECK)
+	{
+		/* Add to draw pile */
+		g->draw_bits[which / 64] |= bit;
+		g->num_draw++;
+	}
+	else if (where == WHERE_DISCARD)
+	{
+		/* Add to discard pile */
+		g->discard_bits[which / 64] |= bit;
+	}
+
+	/* Set location */
+	c_ptr->where = where;
+}
+
+/*
+ * Rebuild the draw and discard pile sets from the card locations.
+ *
+ * This must be called after card locations are set directly, such as
+ * when the deck is first created.
+ */
+void rebuild_piles(game *g)
 {
 	card *c_ptr;
 	int i;
 
+	/* Clear sets */
+	memset(g->draw_bits, 0, sizeof(g->draw_bits));
+	memset(g->discard_bits, 0, sizeof(g->discard_bits));
+
 	/* Loop over cards */
 	for (i = 0; i < g->deck_size; i++)
 	{
 		/* Get card pointer */
 		c_ptr = &g->deck[i];
 
-		/* Check for card in draw deck */
-		if (c_ptr->where == WHERE_DECK) return 0;
+		/* Add cards in draw pile */
+		if (c_ptr->where == WHERE_DECK)
+			g->draw_bits[i / 64] |= 1ULL << (i % 64);
+
+		/* Add cards in discard pile */
+		if (c_ptr->where == WHERE_DISCARD)
+			g->discard_bits[i / 64] |= 1ULL << (i % 64);
 	}
 
-	/* Deck is empty */
-	return 1;
+	/* Count draw pile */
+	g->num_draw = count_card_set(g->draw_bits);
+}
+
+/*
+ * Return the index of the n'th card (counting from zero) of the draw pile.
+ *
+ * Cards are counted in deck order, so that the same random number always
+ * selects the same card.
+ */
+static int nth_draw(game *g, int n)
+{
+	uint64_t bits;
+	int i, c;
+
+	/* Loop over words */
+	for (i = 0; i < CARD_WORDS; i++)
+	{
+		/* Get cards in word */
+		bits = g->draw_bits[i];
+
+		/* Count cards in word */
+		c = __builtin_popcountll(bits);
+
+		/* Skip word if chosen card is later */
+		if (n >= c)
+		{
+			/* Skip cards in word */
+			n -= c;
+			continue;
+		}
+
+		/* Remove earlier cards in word */
+		while (n--) bits &= bits - 1;
+
+		/* Return chosen card */
+		return i * 64 + __builtin_ctzll(bits);
+	}
+
+	/* No such card */
+	return -1;
 }
 
 /*
@@ -210,6 +437,13 @@ int count_player_area(game *g, int who, int where)
 {
 	int x, n = 0;
 
+	/* Count hand from set of cards */
+	if (where == WHERE_HAND) return count_card_set(g->p[who].hand_bits);
+
+	/* Count active area from set of cards */
+	if (where == WHERE_ACTIVE)
+		return count_card_set(g->p[who].active_bits);
+
 	/* Get first card of area chosen */
 	x = g->p[who].head[where];
 
@@ -229,20 +463,10 @@ int count_player_area(game *g, int who, int where)
  */
 int player_has(game *g, int who, design *d_ptr)
 {
-	int x;
+	int i = d_ptr->index;
 
-	/* Get first active card */
-	x = g->p[who].head[WHERE_ACTIVE];
-
-	/* Loop over cards */
-	for ( ; x != -1; x = g->deck[x].next)
-	{
-		/* Check for matching type */
-		if (g->deck[x].d_ptr == d_ptr) return 1;
-	}
-
-	/* Assume not */
-	return 0;
+	/* Check set of active designs */
+	return (g->p[who].active_design[i / 64] >> (i % 64)) & 1;
 }
 
 /*
@@ -252,16 +476,39 @@ int player_has(game *g, int who, design *d_ptr)
  */
 int count_active_flags(game *g, int who, int flags)
 {
-	int x, count = 0;
+	player *p_ptr;
+	uint64_t bits;
+	int i, x, f, count = 0;
 
-	/* Start at first active card */
-	x = g->p[who].start_head[WHERE_ACTIVE];
+	/* Get player pointer */
+	p_ptr = &g->p[who];
 
-	/* Loop over cards */
-	for ( ; x != -1; x = g->deck[x].start_next)
+	/* Check for single flag */
+	if (!(flags & (flags - 1)))
 	{
-		/* Check for correct flags */
-		if ((g->deck[x].d_ptr->flags & flags) == flags) count++;
+		/* Return count of cards with flag */
+		return p_ptr->start_flag_count[__builtin_ctz(flags)];
+	}
+
+	/* Loop over flags */
+	for (f = flags; f; f &= f - 1)
+	{
+		/* Check for no cards with flag */
+		if (!p_ptr->start_flag_count[__builtin_ctz(f)]) return 0;
+	}
+
+	/* Loop over words of active cards */
+	for (i = 0; i < CARD_WORDS; i++)
+	{
+		/* Loop over cards in word */
+		for (bits = p_ptr->start_active_bits[i]; bits; bits &= bits - 1)
+		{
+			/* Get card index */
+			x = i * 64 + __builtin_ctzll(bits);
+
+			/* Check for correct flags */
+			if ((g->deck[x].d_ptr->flags & flags) == flags) count++;
+		}
 	}
 
 	/* Return count */
@@ -332,8 +579,8 @@ int prestige_on_tile(game *g, int who)
  */
 static void refresh_draw(game *g)
 {
-	card *c_ptr;
-	int i;
+	uint64_t bits;
+	int i, x;
 
 	/* Message */
 	if (!g->simulation)
@@ -342,21 +589,29 @@ static void refresh_draw(game *g)
 		message_add_formatted(g, "Refreshing draw deck.\n", FORMAT_EM);
 	}
 
-	/* Loop over cards */
-	for (i = 0; i < g->deck_size; i++)
+	/* Loop over words of discard pile */
+	for (i = 0; i < CARD_WORDS; i++)
 	{
-		/* Get card pointer */
-		c_ptr = &g->deck[i];
+		/* Loop over cards in word */
+		for (bits = g->discard_bits[i]; bits; bits &= bits - 1)
+		{
+			/* Get card index */
+			x = i * 64 + __builtin_ctzll(bits);
 
-		/* Skip cards not in discard pile */
-		if (c_ptr->where != WHERE_DISCARD) continue;
+			/* Move card to draw deck */
+			g->deck[x].where = WHERE_DECK;
 
-		/* Move card to draw deck */
-		c_ptr->where = WHERE_DECK;
+			/* Card's location is no longer known to anyone */
+			g->deck[x].misc &= ~MISC_KNOWN_MASK;
+		}
 
-		/* Card's location is no longer known to anyone */
-		c_ptr->misc &= ~MISC_KNOWN_MASK;
+		/* Move word of cards to draw pile */
+		g->draw_bits[i] |= g->discard_bits[i];
+		g->discard_bits[i] = 0;
 	}
+
+	/* Count draw pile */
+	g->num_draw = count_card_set(g->draw_bits);
 }
 
 /*
@@ -364,23 +619,16 @@ static void refresh_draw(game *g)
  */
 int random_draw(game *g)
 {
-	card *c_ptr = NULL;
 	int i, n;
 
-	/* Count draw deck size */
-	n = count_draw(g);
-
 	/* Check for no cards */
-	if (!n)
+	if (!g->num_draw)
 	{
 		/* Refresh draw deck */
 		refresh_draw(g);
 
-		/* Recount */
-		n = count_draw(g);
-
 		/* Check for still no cards */
-		if (!n)
+		if (!g->num_draw)
 		{
 			/* No card to return */
 			return -1;
@@ -388,26 +636,16 @@ int random_draw(game *g)
 	}
 
 	/* Choose randomly */
-	n = game_rand(g) % n;
-
-	/* Loop over cards */
-	for (i = 0; i < g->deck_size; i++)
-	{
-		/* Get card pointer */
-		c_ptr = &g->deck[i];
-
-		/* Skip cards not in draw deck */
-		if (c_ptr->where != WHERE_DECK) continue;
+	n = game_rand(g) % g->num_draw;
 
-		/* Check for chosen card */
-		if (!(n--)) break;
-	}
+	/* Find chosen card */
+	i = nth_draw(g, n);
 
 	/* Clear chosen card's location */
-	c_ptr->where = -1;
+	set_where(g, i, -1);
 
 	/* Check for just-emptied draw pile */
-	if (draw_empty(g)) refresh_draw(g);
+	if (!g->num_draw) refresh_draw(g);
 
 	/* Return chosen card */
 	return i;
@@ -437,66 +675,338 @@ static int campaign_draw(game *g, int who)
 	/* Check for random card */
 	if (which < 0) which = random_draw(g);
 
-	/* Return card */
-	return which;
+	/* Return card */
+	return which;
+}
+
+/*
+ * Return the first card pointer from the draw deck.
+ *
+ * We use this in simulated games for choosing cards to be used as goods
+ * and other non-essential tasks.  We don't want to use the random number
+ * generator in these cases.
+ */
+int first_draw(game *g)
+{
+	int i;
+
+	/* Check for empty draw pile */
+	if (!g->num_draw)
+	{
+		/* Refresh draw pile */
+		refresh_draw(g);
+
+		/* Check for still empty */
+		if (!g->num_draw) return -1;
+	}
+
+	/* Get first card */
+	i = nth_draw(g, 0);
+
+	/* Clear chosen card's location */
+	set_where(g, i, -1);
+
+	/* Check for just-emptied draw pile */
+	if (!g->num_draw) refresh_draw(g);
+
+	/* Return chosen card */
+	return i;
+}
+
+/*
+ * Adjust a player's goal progress counts for a card entering or leaving
+ * their active area.
+ */
+static void adjust_goal_counts(player *p_ptr, design *d_ptr, int add)
+{
+	power *o_ptr;
+	int phase[6];
+	int i;
+
+	/* Check for world */
+	if (d_ptr->type == TYPE_WORLD)
+	{
+		/* Count world and its good type */
+		p_ptr->goal_worlds += add;
+		p_ptr->goal_good_type[d_ptr->good_type] += add;
+
+		/* Count production worlds */
+		if (!(d_ptr->flags & FLAG_WINDFALL) && d_ptr->good_type)
+			p_ptr->goal_production += add;
+	}
+	else
+	{
+		/* Count development */
+		p_ptr->goal_devels += add;
+
+		/* Count six-cost developments with variable points */
+		if (d_ptr->cost == 6 && d_ptr->num_vp_bonus)
+			p_ptr->goal_six_devels += add;
+	}
+
+	/* Clear phase marks */
+	for (i = 0; i < 6; i++) phase[i] = 0;
+
+	/* Loop over card powers */
+	for (i = 0; i < d_ptr->num_power; i++)
+	{
+		/* Get power pointer */
+		o_ptr = &d_ptr->powers[i];
+
+		/* Check for trade power */
+		if (o_ptr->phase == PHASE_CONSUME &&
+		    (o_ptr->code & P4_TRADE_MASK))
+		{
+			/* XXX Mark trade power */
+			phase[0] = 1;
+		}
+		else
+		{
+			/* Mark phase */
+			phase[o_ptr->phase] = 1;
+		}
+	}
+
+	/* Count card once for each phase it has powers in */
+	for (i = 0; i < 6; i++) p_ptr->goal_phase[i] += add * phase[i];
+}
+
+/*
+ * Return the VP a scoring card's bonuses award for one active card.
+ *
+ * Only the first matching bonus counts.
+ */
+static int bonus_card_vp(game *g, design *score, design *d_ptr)
+{
+	vp_bonus *v_ptr;
+	int i;
+
+	/* Loop over bonuses */
+	for (i = 0; i < score->num_vp_bonus; i++)
+	{
+		/* Get bonus pointer */
+		v_ptr = &score->bonuses[i];
+
+		/* Check for match */
+		if (bonus_match(g, v_ptr, d_ptr)) return v_ptr->point;
+	}
+
+	/* No match */
+	return 0;
+}
+
+/*
+ * Return whether bonuses matching the given card depend on game state.
+ *
+ * Windfall bonuses match an "any" kind world by its current kind, so
+ * these cards are matched when scoring instead of being cached.
+ */
+static int bonus_uncached(design *d_ptr)
+{
+	return d_ptr->good_type == GOOD_ANY;
+}
+
+/*
+ * Adjust a player's cached card points for a card entering or leaving
+ * their active area.
+ *
+ * The card must be in the player's active list when this is called.
+ */
+static void adjust_card_vp(game *g, player *p_ptr, card *c_ptr, int add)
+{
+	design *d_ptr, *o_ptr;
+	int x, amt = 0;
+
+	/* Get card design */
+	d_ptr = c_ptr->d_ptr;
+
+	/* Adjust printed points */
+	p_ptr->card_vp += add * d_ptr->vp;
+
+	/* Start at first active card */
+	x = p_ptr->head[WHERE_ACTIVE];
+
+	/* Loop over active cards (including this one) */
+	for ( ; x != -1; x = g->deck[x].next)
+	{
+		/* Get other card's design */
+		o_ptr = g->deck[x].d_ptr;
+
+		/* Add bonus from this card for other card */
+		if (d_ptr->num_vp_bonus && !bonus_uncached(o_ptr))
+			amt += bonus_card_vp(g, d_ptr, o_ptr);
+
+		/* Skip this card itself */
+		if (&g->deck[x] == c_ptr) continue;
+
+		/* Add bonus from other card for this card */
+		if (o_ptr->num_vp_bonus && !bonus_uncached(d_ptr))
+			amt += bonus_card_vp(g, o_ptr, d_ptr);
+	}
+
+	/* Adjust bonus points */
+	p_ptr->bonus_vp += add * amt;
+}
+
+/*
+ * Add an event to the game's event log.
+ *
+ * Simulated games and games without a log record nothing.
+ */
+static void add_event(game *g, int type, int who, int a0, int a1, int a2,
+                      int a3)
+{
+	game_event *e;
+
+	/* Check for no log or simulated game */
+	if (!g->events || g->simulation) return;
+
+	/* Get next slot in ring */
+	e = &g->events->event[g->events->head++ & (EVENT_LOG_SIZE - 1)];
+
+	/* Copy event */
+	e->type = type;
+	e->who = who;
+	e->round = g->round;
+	e->action = g->cur_action;
+	e->arg[0] = a0;
+	e->arg[1] = a1;
+	e->arg[2] = a2;
+	e->arg[3] = a3;
+}
+
+/*
+ * Start recording a game's events in the given log.
+ *
+ * Initializing or loading a game leaves it without a log, so the owner
+ * starts its log again afterwards.
+ */
+void start_events(game *g, event_log *l_ptr)
+{
+	/* Clear log */
+	l_ptr->head = 0;
+
+	/* Record events in log */
+	g->events = l_ptr;
+}
+
+/*
+ * Return the event at the given position in the game's event log, and
+ * advance the position.
+ *
+ * Events that have already been overwritten are skipped, and a position
+ * past the end of a cleared log starts over.  Return NULL when no more
+ * events are available.
+ */
+game_event *next_event(game *g, uint32_t *pos)
+{
+	event_log *l_ptr = g->events;
+
+	/* Check for no log */
+	if (!l_ptr) return NULL;
+
+	/* Start over if the log has been cleared since */
+	if (*pos > l_ptr->head) *pos = 0;
+
+	/* Check for no new events */
+	if (*pos == l_ptr->head) return NULL;
+
+	/* Skip events that have been overwritten */
+	if (l_ptr->head - *pos > EVENT_LOG_SIZE)
+		*pos = l_ptr->head - EVENT_LOG_SIZE;
+
+	/* Return event and advance */
+	return &l_ptr->event[(*pos)++ & (EVENT_LOG_SIZE - 1)];
+}
+
+/*
+ * Return the name of a card location in an event.
+ *
+ * Cards just drawn have no location until they are moved, so they are
+ * named as coming from the deck.
+ */
+static char *event_where(int where)
+{
+	/* Check for drawn card */
+	if (where < 0) return location_names[WHERE_DECK];
+
+	/* Return location name */
+	return location_names[where];
 }
 
 /*
- * Return the first card pointer from the draw deck.
- *
- * We use this in simulated games for choosing cards to be used as goods
- * and other non-essential tasks.  We don't want to use the random number
- * generator in these cases.
+ * Format an event as text.
  */
-int first_draw(game *g)
+void format_event(game *g, game_event *e, char *buf)
 {
-	card *c_ptr = NULL;
-	int i;
+	char *name;
 
-	/* Loop over cards */
-	for (i = 0; i < g->deck_size; i++)
+	/* Get name of player involved */
+	name = e->who >= 0 ? g->p[e->who].name : "Nobody";
+
+	/* Switch on type of event */
+	switch (e->type)
 	{
-		/* Get card pointer */
-		c_ptr = &g->deck[i];
+		/* Start of round */
+		case EVENT_ROUND:
 
-		/* Skip cards not in draw deck */
-		if (c_ptr->where != WHERE_DECK) continue;
+			/* Format round number */
+			sprintf(buf, "Round %d begins.\n", e->arg[0]);
+			break;
 
-		/* Stop at first valid card */
-		break;
-	}
+		/* Start of phase */
+		case EVENT_PHASE:
 
-	/* Check for empty draw pile */
-	if (i == g->deck_size)
-	{
-		/* Refresh draw pile */
-		refresh_draw(g);
+			/* Format phase name */
+			sprintf(buf, "%s phase begins.\n",
+			        plain_actname[e->arg[0]]);
+			break;
 
-		/* Loop over cards again */
-		for (i = 0; i < g->deck_size; i++)
-		{
-			/* Get card pointer */
-			c_ptr = &g->deck[i];
+		/* Card moved */
+		case EVENT_MOVE:
+
+			/* Format card and locations */
+			sprintf(buf, "%s moves from %s %s to %s %s.\n",
+			        g->deck[e->arg[0]].d_ptr->name,
+			        e->arg[1] >= 0 ? g->p[e->arg[1]].name : "the",
+			        event_where(e->arg[2]),
+			        e->who >= 0 ? name : "the",
+			        event_where(e->arg[3]));
+			break;
 
-			/* Skip cards not in draw deck */
-			if (c_ptr->where != WHERE_DECK) continue;
+		/* VP gained */
+		case EVENT_VP:
 
-			/* Stop at first valid card */
+			/* Format VP gained */
+			sprintf(buf, "%s gains %d VP%s (%d left in pool).\n",
+			        name, e->arg[0], PLURAL(e->arg[0]), e->arg[1]);
 			break;
-		}
 
-		/* Check for still empty */
-		if (i == g->deck_size) return -1;
-	}
+		/* Choice made */
+		case EVENT_CHOICE:
 
-	/* Clear chosen card's location */
-	c_ptr->where = -1;
+			/* Format choice and answer */
+			sprintf(buf, "%s answers choice %d with %d "
+			        "(%d item%s).\n", name, e->arg[0], e->arg[1],
+			        e->arg[2], PLURAL(e->arg[2]));
+			break;
 
-	/* Check for just-emptied draw pile */
-	if (draw_empty(g)) refresh_draw(g);
+		/* End of game */
+		case EVENT_GAME_OVER:
 
-	/* Return chosen card */
-	return i;
+			/* Format final score */
+			sprintf(buf, "%s ends with %d VP%s%s.\n", name,
+			        e->arg[0], PLURAL(e->arg[0]),
+			        e->arg[1] ? " and wins" : "");
+			break;
+
+		/* Unknown event */
+		default:
+
+			/* Format type */
+			sprintf(buf, "Unknown event %d.\n", e->type);
+			break;
+	}
 }
 
 /*
@@ -508,17 +1018,33 @@ void move_card(game *g, int which, int owner, int where)
 {
 	player *p_ptr;
 	card *c_ptr;
-	int x;
+	uint64_t bit = 1ULL << (which % 64), dbit;
+	int x, d;
 
 	/* Get card pointer */
 	c_ptr = &g->deck[which];
 
+	/* Get card's design index and bit */
+	d = c_ptr->d_ptr->index;
+	dbit = 1ULL << (d % 64);
+
+	/* Discard powers only count while card is active */
+	if (c_ptr->start_where == WHERE_ACTIVE) g->power_version++;
+
 	/* Check for current owner */
 	if (c_ptr->owner != -1)
 	{
 		/* Get pointer of current owner */
 		p_ptr = &g->p[c_ptr->owner];
 
+		/* Remove card from sets */
+		p_ptr->hand_bits[which / 64] &= ~bit;
+		p_ptr->active_bits[which / 64] &= ~bit;
+
+		/* Remove points of active card */
+		if (c_ptr->where == WHERE_ACTIVE)
+			adjust_card_vp(g, p_ptr, c_ptr, -1);
+
 		/* Find card in list */
 		x = p_ptr->head[c_ptr->where];
 
@@ -542,6 +1068,27 @@ void move_card(game *g, int which, int owner, int where)
 			g->deck[x].next = c_ptr->next;
 			c_ptr->next = -1;
 		}
+
+		/* Check for card leaving active area */
+		if (c_ptr->where == WHERE_ACTIVE)
+		{
+			/* Start at first remaining active card */
+			x = p_ptr->head[WHERE_ACTIVE];
+
+			/* Loop over remaining active cards */
+			for ( ; x != -1; x = g->deck[x].next)
+			{
+				/* Stop at another card of same design */
+				if (g->deck[x].d_ptr == c_ptr->d_ptr) break;
+			}
+
+			/* Remove design from set unless another card has it */
+			if (x == -1)
+				p_ptr->active_design[d / 64] &= ~dbit;
+
+			/* Remove card from goal progress counts */
+			adjust_goal_counts(p_ptr, c_ptr->d_ptr, -1);
+		}
 	}
 
 	/* Check for new owner */
@@ -553,11 +1100,81 @@ void move_card(game *g, int which, int owner, int where)
 		/* Add card to beginning of list */
 		c_ptr->next = p_ptr->head[where];
 		p_ptr->head[where] = which;
+
+		/* Add card to set of hand cards */
+		if (where == WHERE_HAND) p_ptr->hand_bits[which / 64] |= bit;
+
+		/* Check for active card */
+		if (where == WHERE_ACTIVE)
+		{
+			/* Add card and design to sets */
+			p_ptr->active_bits[which / 64] |= bit;
+			p_ptr->active_design[d / 64] |= dbit;
+
+			/* Add card to goal progress counts */
+			adjust_goal_counts(p_ptr, c_ptr->d_ptr, 1);
+
+			/* Add points of card */
+			adjust_card_vp(g, p_ptr, c_ptr, 1);
+		}
 	}
 
+	/* Record move */
+	add_event(g, EVENT_MOVE, owner, which, c_ptr->owner, c_ptr->where,
+	          where);
+
 	/* Adjust location */
 	c_ptr->owner = owner;
-	c_ptr->where = where;
+	set_where(g, which, where);
+}
+
+/*
+ * Adjust the start of phase set of active cards and their flag counts.
+ */
+static void adjust_start_active(player *p_ptr, card *c_ptr, int which,
+                                int add)
+{
+	uint32_t f;
+
+	/* Add or remove card */
+	if (add) p_ptr->start_active_bits[which / 64] |= 1ULL << (which % 64);
+	else p_ptr->start_active_bits[which / 64] &= ~(1ULL << (which % 64));
+
+	/* Loop over card's flags */
+	for (f = c_ptr->d_ptr->flags; f; f &= f - 1)
+	{
+		/* Adjust count of cards with flag */
+		p_ptr->start_flag_count[__builtin_ctz(f)] += add ? 1 : -1;
+	}
+}
+
+/*
+ * Clear a player's sets and counts of cards.
+ *
+ * This must be called whenever a player's lists of cards are cleared.
+ */
+void clear_card_sets(player *p_ptr)
+{
+	/* Clear sets */
+	memset(p_ptr->hand_bits, 0, sizeof(p_ptr->hand_bits));
+	memset(p_ptr->active_bits, 0, sizeof(p_ptr->active_bits));
+	memset(p_ptr->active_design, 0, sizeof(p_ptr->active_design));
+	memset(p_ptr->start_active_bits, 0, sizeof(p_ptr->start_active_bits));
+
+	/* Clear flag counts */
+	memset(p_ptr->start_flag_count, 0, sizeof(p_ptr->start_flag_count));
+
+	/* Clear goal progress counts */
+	p_ptr->goal_worlds = p_ptr->goal_devels = 0;
+	p_ptr->goal_six_devels = p_ptr->goal_production = 0;
+	memset(p_ptr->goal_good_type, 0, sizeof(p_ptr->goal_good_type));
+	memset(p_ptr->goal_phase, 0, sizeof(p_ptr->goal_phase));
+
+	/* Clear cached card points */
+	p_ptr->card_vp = p_ptr->bonus_vp = 0;
+
+	/* Military strength is not computed */
+	p_ptr->mil_version = 0;
 }
 
 /*
@@ -581,6 +1198,13 @@ void move_start(game *g, int which, int owner, int where)
 		/* Get pointer of current owner */
 		p_ptr = &g->p[c_ptr->start_owner];
 
+		/* Check for card leaving active area */
+		if (c_ptr->start_where == WHERE_ACTIVE)
+		{
+			/* Remove card from start of phase set */
+			adjust_start_active(p_ptr, c_ptr, which, 0);
+		}
+
 		/* Find card in list */
 		x = p_ptr->start_head[c_ptr->start_where];
 
@@ -616,11 +1240,21 @@ void move_start(game *g, int which, int owner, int where)
 		/* Add card to beginning of list */
 		c_ptr->start_next = p_ptr->start_head[where];
 		p_ptr->start_head[where] = which;
+
+		/* Check for active card */
+		if (where == WHERE_ACTIVE)
+		{
+			/* Add card to start of phase set */
+			adjust_start_active(p_ptr, c_ptr, which, 1);
+		}
 	}
 
 	/* Adjust location */
 	c_ptr->start_owner = owner;
 	c_ptr->start_where = where;
+
+	/* Start of phase powers have changed */
+	g->power_version++;
 }
 
 /*
@@ -659,7 +1293,7 @@ int draw_card(game *g, int who, char *reason)
 		c_ptr = &g->deck[which];
 
 		/* Move card to discard to simulate deck cycling */
-		c_ptr->where = WHERE_DISCARD;
+		set_where(g, which, WHERE_DISCARD);
 
 		/* Done */
 		return which;
@@ -925,7 +1559,8 @@ void clear_temp(game *g)
 {
 	player *p_ptr;
 	card *c_ptr;
-	int i, j;
+	uint32_t f;
+	int i, j, x;
 
 	/* Loop over cards */
 	for (i = 0; i < g->deck_size; i++)
@@ -944,6 +1579,9 @@ void clear_temp(game *g)
 		c_ptr->misc &= MISC_TEMP_MASK;
 	}
 
+	/* Start of phase powers have changed */
+	g->power_version++;
+
 	/* Loop over players */
 	for (i = 0; i < g->num_players; i++)
 	{
@@ -969,6 +1607,26 @@ void clear_temp(game *g)
 			/* Copy start of list */
 			p_ptr->start_head[j] = p_ptr->head[j];
 		}
+
+		/* Copy set of active cards */
+		memcpy(p_ptr->start_active_bits, p_ptr->active_bits,
+		       sizeof(p_ptr->active_bits));
+
+		/* Clear flag counts */
+		memset(p_ptr->start_flag_count, 0,
+		       sizeof(p_ptr->start_flag_count));
+
+		/* Loop over active cards */
+		x = p_ptr->head[WHERE_ACTIVE];
+		for ( ; x != -1; x = g->deck[x].next)
+		{
+			/* Loop over card's flags */
+			for (f = g->deck[x].d_ptr->flags; f; f &= f - 1)
+			{
+				/* Count card with flag */
+				p_ptr->start_flag_count[__builtin_ctz(f)]++;
+			}
+		}
 	}
 }
 
@@ -1154,6 +1812,9 @@ static int extract_choice(game *g, int who, int type, int list[], int *nl,
 	/* Update unread position */
 	p_ptr->choice_unread_pos = p_ptr->choice_pos;
 
+	/* Record choice */
+	add_event(g, EVENT_CHOICE, who, type, rv, nl ? *nl : 0, 0);
+
 	/* Return logged answer */
 	return rv;
 }
@@ -1401,8 +2062,9 @@ void player_discard(game *g, int who, int discard)
 int get_powers(game *g, int who, int phase, power_where *w_list)
 {
 	card *c_ptr;
+	power_table *t_ptr;
 	power *o_ptr;
-	int x, i, n = 0;
+	int x, i, j, n = 0;
 
 	/* Get first active card */
 	x = g->p[who].start_head[WHERE_ACTIVE];
@@ -1413,21 +2075,27 @@ int get_powers(game *g, int who, int phase, power_where *w_list)
 		/* Get card pointer */
 		c_ptr = &g->deck[x];
 
-		/* Loop over card's powers */
-		for (i = 0; i < c_ptr->d_ptr->num_power; i++)
+		/* Get card's power summary */
+		t_ptr = &power_info[c_ptr->d_ptr->index];
+
+		/* Skip cards without powers in this phase */
+		if (!(t_ptr->phase_mask & (1 << phase))) continue;
+
+		/* Loop over card's powers in this phase */
+		for (j = 0; j < t_ptr->num[phase]; j++)
 		{
-			/* Get power pointer */
-			o_ptr = &c_ptr->d_ptr->powers[i];
+			/* Get power index */
+			i = t_ptr->index[phase][j];
 
 			/* Skip used powers */
 			if (c_ptr->misc & (1 << (MISC_USED_SHIFT + i)))
 				continue;
 
-			/* Skip incorrect phase */
-			if (o_ptr->phase != phase) continue;
+			/* Get power pointer */
+			o_ptr = &c_ptr->d_ptr->powers[i];
 
 			/* Check for settle phase and discard power */
-			if (o_ptr->phase == PHASE_SETTLE &&
+			if (phase == PHASE_SETTLE &&
 			    (o_ptr->code & P3_DISCARD) &&
 			    c_ptr->where != WHERE_ACTIVE) continue;
 
@@ -1444,6 +2112,18 @@ int get_powers(game *g, int who, int phase, power_where *w_list)
 	return n;
 }
 
+/*
+ * Mark a card's power as used.
+ */
+static void mark_power_used(game *g, card *c_ptr, int o_idx)
+{
+	/* Set used flag */
+	c_ptr->misc |= 1 << (MISC_USED_SHIFT + o_idx);
+
+	/* Available powers have changed */
+	g->power_version++;
+}
+
 /*
  * Add a good to a played card.
  */
@@ -2279,7 +2959,9 @@ void place_card(game *g, int who, int which)
 		if (c_ptr->d_ptr->flags & FLAG_PRESTIGE)
 		{
 			/* Format reason */
-			sprintf(reason, "placing %s", c_ptr->d_ptr->name);
+			if (!g->simulation)
+				sprintf(reason, "placing %s",
+				        c_ptr->d_ptr->name);
 
 			/* Add prestige to player */
 			gain_prestige(g, who, 1, reason);
@@ -3225,32 +3907,31 @@ void phase_develop(game *g)
 }
 
 /*
- * Return player's military strength against the given world.
- * Includes cost of world if defending.
+ * Compute a player's military strength from their Settle phase powers,
+ * unless it is already known for the current power version.
+ *
+ * This computes the non-specific military, and the extra military that
+ * applies against each kind of world.
  */
-int strength_against(game *g, int who, int world, int attack, int defend)
+static void update_military(game *g, int who)
 {
 	player *p_ptr;
-	card *c_ptr;
 	power_where w_list[100];
 	power *o_ptr;
-	int i, n;
-	int military, good;
+	int i, j, n, good, rebel, defend;
+	int amt;
 
 	/* Get player pointer */
 	p_ptr = &g->p[who];
 
-	/* Get card pointer */
-	c_ptr = &g->deck[world];
-
-	/* Get world's good type */
-	good = c_ptr->d_ptr->good_type;
+	/* Check for strength already known */
+	if (p_ptr->mil_version == g->power_version) return;
 
 	/* Get Settle phase powers */
 	n = get_powers(g, who, PHASE_SETTLE, w_list);
 
-	/* Count non-specific military */
-	military = total_military(g, who);
+	/* Start with no military */
+	amt = 0;
 
 	/* Loop over powers */
 	for (i = 0; i < n; i++)
@@ -3258,43 +3939,139 @@ int strength_against(game *g, int who, int world, int attack, int defend)
 		/* Get power pointer */
 		o_ptr = w_list[i].o_ptr;
 
-		/* Check for specific extra military */
-		if (o_ptr->code & P3_EXTRA_MILITARY)
+		/* Check for non-specific military */
+		if (o_ptr->code == P3_EXTRA_MILITARY)
 		{
-			/* Check for specific good required */
-			if (((o_ptr->code & P3_NOVELTY) && good == GOOD_NOVELTY) ||
-			    ((o_ptr->code & P3_RARE) && good == GOOD_RARE) ||
-			    ((o_ptr->code & P3_GENE) && good == GOOD_GENE) ||
-			    ((o_ptr->code & P3_ALIEN) && good == GOOD_ALIEN))
-			{
-				/* Add value */
-				military += o_ptr->value;
-				continue;
-			}
+			/* Add to military */
+			amt += o_ptr->value;
+		}
 
-			/* Check for against rebels */
-			if ((o_ptr->code & P3_AGAINST_REBEL) &&
-			    (c_ptr->d_ptr->flags & FLAG_REBEL))
+		/* Check for non-specific military per military world */
+		if (o_ptr->code == (P3_EXTRA_MILITARY | P3_PER_MILITARY))
+		{
+			/* Add to military */
+			amt += count_active_flags(g, who, FLAG_MILITARY);
+		}
+
+		/* Check for non-specific military per chromosome flag */
+		if (o_ptr->code == (P3_EXTRA_MILITARY | P3_PER_CHROMO))
+		{
+			/* Add to military */
+			amt += count_active_flags(g, who, FLAG_CHROMO);
+		}
+
+		/* Check for only if Imperium card active */
+		if (o_ptr->code == (P3_EXTRA_MILITARY | P3_IF_IMPERIUM))
+		{
+			/* Check for Imperium flag */
+			if (count_active_flags(g, who, FLAG_IMPERIUM))
 			{
-				/* Add value */
-				military += o_ptr->value;
-				continue;
+				/* Add power's value */
+				amt += o_ptr->value;
 			}
 		}
+	}
+
+	/* Save non-specific military */
+	p_ptr->mil_total = amt;
 
-		/* Check for takeover defense */
-		if (defend && (o_ptr->code & P3_TAKEOVER_DEFENSE))
+	/* Loop over kinds of world */
+	for (j = 0; j < MAX_GOOD * 2 * 2; j++)
+	{
+		/* Get world's good type, Rebel flag and defense */
+		good = j / 4;
+		rebel = (j / 2) % 2;
+		defend = j % 2;
+
+		/* Start with no extra military */
+		amt = 0;
+
+		/* Loop over powers */
+		for (i = 0; i < n; i++)
 		{
-			/* Add defense for military worlds */
-			military += count_active_flags(g, who,
-			                               FLAG_MILITARY);
+			/* Get power pointer */
+			o_ptr = w_list[i].o_ptr;
+
+			/* Check for specific extra military */
+			if (o_ptr->code & P3_EXTRA_MILITARY)
+			{
+				/* Check for specific good required */
+				if (((o_ptr->code & P3_NOVELTY) &&
+				     good == GOOD_NOVELTY) ||
+				    ((o_ptr->code & P3_RARE) &&
+				     good == GOOD_RARE) ||
+				    ((o_ptr->code & P3_GENE) &&
+				     good == GOOD_GENE) ||
+				    ((o_ptr->code & P3_ALIEN) &&
+				     good == GOOD_ALIEN))
+				{
+					/* Add value */
+					amt += o_ptr->value;
+					continue;
+				}
 
-			/* Add extra defense for Rebel military worlds */
-			military += count_active_flags(g, who,
-			                          (FLAG_REBEL | FLAG_MILITARY));
+				/* Check for against rebels */
+				if ((o_ptr->code & P3_AGAINST_REBEL) && rebel)
+				{
+					/* Add value */
+					amt += o_ptr->value;
+					continue;
+				}
+			}
+
+			/* Check for takeover defense */
+			if (defend && (o_ptr->code & P3_TAKEOVER_DEFENSE))
+			{
+				/* Add defense for military worlds */
+				amt += count_active_flags(g, who,
+				                          FLAG_MILITARY);
+
+				/* Add extra defense for Rebel military worlds */
+				amt += count_active_flags(g, who,
+				                          (FLAG_REBEL |
+				                           FLAG_MILITARY));
+			}
 		}
+
+		/* Save extra military */
+		p_ptr->mil_against[good][rebel][defend] = amt;
 	}
 
+	/* Remember version */
+	p_ptr->mil_version = g->power_version;
+}
+
+/*
+ * Return player's military strength against the given world.
+ * Includes cost of world if defending.
+ */
+int strength_against(game *g, int who, int world, int attack, int defend)
+{
+	player *p_ptr;
+	card *c_ptr;
+	power *o_ptr;
+	int i, rebel;
+	int military, good;
+
+	/* Get player pointer */
+	p_ptr = &g->p[who];
+
+	/* Get card pointer */
+	c_ptr = &g->deck[world];
+
+	/* Get world's good type */
+	good = c_ptr->d_ptr->good_type;
+
+	/* Check for Rebel world */
+	rebel = (c_ptr->d_ptr->flags & FLAG_REBEL) ? 1 : 0;
+
+	/* Compute military strength if needed */
+	update_military(g, who);
+
+	/* Count non-specific and specific military */
+	military = p_ptr->mil_total +
+	           p_ptr->mil_against[good][rebel][defend ? 1 : 0];
+
 	/* Check for attack used */
 	if (attack >= 0)
 	{
@@ -3719,7 +4496,6 @@ int settle_needed(game *g, int who, int which, int special[], int num_special,
 	card *c_ptr, *t_ptr;
 	power_where w_list[100];
 	power *o_ptr;
-	char *name;
 	int conquer, pay_military = 0, military, cost, good;
 	int hand_military = 0, conquer_peaceful = 0;
 	int discard_zero = 0, takeover = 0;
@@ -3773,9 +4549,6 @@ int settle_needed(game *g, int who, int which, int special[], int num_special,
 			/* Get power pointer */
 			o_ptr = &c_ptr->d_ptr->powers[j];
 
-			/* Get name of card with power */
-			name = c_ptr->d_ptr->name;
-
 			/* Skip non-settle phase power */
 			if (o_ptr->phase != PHASE_SETTLE) continue;
 
@@ -4232,7 +5005,7 @@ int settle_callback(game *g, int who, int which, int list[], int num,
 				}
 
 				/* Mark power as used */
-				c_ptr->misc |= 1 << (MISC_USED_SHIFT + j);
+				mark_power_used(g, c_ptr, j);
 
 				/* Assume cards are for military strength */
 				hand_military += o_ptr->value;
@@ -4242,7 +5015,7 @@ int settle_callback(game *g, int who, int which, int list[], int num,
 			if (o_ptr->code & P3_CONSUME_GENE)
 			{
 				/* Mark power as used */
-				c_ptr->misc |= 1 << (MISC_USED_SHIFT + j);
+				mark_power_used(g, c_ptr, j);
 
 				/* Remember power is used */
 				consume_reduce++;
@@ -4275,7 +5048,7 @@ int settle_callback(game *g, int who, int which, int list[], int num,
 			if (o_ptr->code & P3_CONSUME_RARE)
 			{
 				/* Mark power as used */
-				c_ptr->misc |= 1 << (MISC_USED_SHIFT + j);
+				mark_power_used(g, c_ptr, j);
 
 				/* Ask for goods to consume later */
 				consume_military++;
@@ -4305,7 +5078,7 @@ int settle_callback(game *g, int who, int which, int list[], int num,
 			if (o_ptr->code & P3_CONSUME_ALIEN)
 			{
 				/* Mark power as used */
-				c_ptr->misc |= 1 << (MISC_USED_SHIFT + j);
+				mark_power_used(g, c_ptr, j);
 
 				/* Ask for goods to consume later */
 				consume_military++;
@@ -4335,7 +5108,7 @@ int settle_callback(game *g, int who, int which, int list[], int num,
 			if (o_ptr->code & P3_CONSUME_PRESTIGE)
 			{
 				/* Mark power as used */
-				c_ptr->misc |= 1 << (MISC_USED_SHIFT + j);
+				mark_power_used(g, c_ptr, j);
 
 				/* Spend prestige */
 				spend_prestige(g, who, 1);
@@ -5063,7 +5836,7 @@ int takeover_callback(game *g, int special, int world)
 		else
 		{
 			/* Mark power as used */
-			c_ptr->misc |= 1 << (MISC_USED_SHIFT + i);
+			mark_power_used(g, c_ptr, i);
 		}
 
 		/* Check for takeover rebel power */
@@ -5990,7 +6763,7 @@ void settle_chosen(game *g, int who, int first, int c_idx, int o_idx)
 	o_ptr = &g->deck[c_idx].d_ptr->powers[o_idx];
 
 	/* Mark power as used */
-	g->deck[c_idx].misc |= 1 << (MISC_USED_SHIFT + o_idx);
+	mark_power_used(g, &g->deck[c_idx], o_idx);
 
 	/* Check for place second world power */
 	if (o_ptr->code & P3_PLACE_TWO)
@@ -6625,7 +7398,7 @@ int defend_callback(game *g, int who, int deficit, int list[], int num,
 			if (o_ptr->code & P3_MILITARY_HAND)
 			{
 				/* Mark power as used */
-				c_ptr->misc |= 1 << (MISC_USED_SHIFT + j);
+				mark_power_used(g, c_ptr, j);
 
 				/* Assume cards are for military strength */
 				hand_military += o_ptr->value;
@@ -6635,7 +7408,7 @@ int defend_callback(game *g, int who, int deficit, int list[], int num,
 			if (o_ptr->code & P3_CONSUME_RARE)
 			{
 				/* Mark power as used */
-				c_ptr->misc |= 1 << (MISC_USED_SHIFT + j);
+				mark_power_used(g, c_ptr, j);
 
 				/* Add extra military */
 				military += o_ptr->value;
@@ -6648,7 +7421,7 @@ int defend_callback(game *g, int who, int deficit, int list[], int num,
 			if (o_ptr->code & P3_CONSUME_ALIEN)
 			{
 				/* Mark power as used */
-				c_ptr->misc |= 1 << (MISC_USED_SHIFT + j);
+				mark_power_used(g, c_ptr, j);
 
 				/* Add extra military */
 				military += o_ptr->value;
@@ -6672,7 +7445,7 @@ int defend_callback(game *g, int who, int deficit, int list[], int num,
 			if (o_ptr->code & P3_CONSUME_PRESTIGE)
 			{
 				/* Mark power as used */
-				c_ptr->misc |= 1 << (MISC_USED_SHIFT + j);
+				mark_power_used(g, c_ptr, j);
 
 				/* Spend prestige */
 				spend_prestige(g, who, 1);
@@ -6848,6 +7621,10 @@ static void defend_takeover(game *g, int who, int world, int attacker,
 		/* Get card pointer */
 		c_ptr = &g->deck[x];
 
+		/* Skip cards without military from hand powers */
+		if (!(power_info[c_ptr->d_ptr->index].code[PHASE_SETTLE] &
+		      P3_MILITARY_HAND)) continue;
+
 		/* Loop over powers on card */
 		for (i = 0; i < c_ptr->d_ptr->num_power; i++)
 		{
@@ -6871,6 +7648,9 @@ static void defend_takeover(game *g, int who, int world, int attacker,
 					c_ptr->misc &= ~(1 <<
 					                 (MISC_USED_SHIFT + i));
 
+					/* Available powers have changed */
+					g->power_version++;
+
 					/* Done looking */
 					break;
 				}
@@ -7355,7 +8135,7 @@ void resolve_takeovers(game *g)
 			if (!(o_ptr->code & P3_PREVENT_TAKEOVER)) continue;
 
 			/* Mark power as used */
-			c_ptr->misc |= 1 << (MISC_USED_SHIFT + w_list[j].o_idx);
+			mark_power_used(g, c_ptr, w_list[j].o_idx);
 
 			/* Ask player which takeover (if any) to defeat */
 			ask_player(g, i, CHOICE_TAKEOVER_PREVENT,
@@ -7917,9 +8697,8 @@ void trade_action(game *g, int who, int no_bonus, int phase_bonus)
 {
 	player *p_ptr;
 	card *c_ptr;
-	power *o_ptr;
 	int list[MAX_DECK], n = 0;
-	int i, x, trade;
+	int x, trade;
 
 	/* Get player pointer */
 	p_ptr = &g->p[who];
@@ -7936,21 +8715,9 @@ void trade_action(game *g, int who, int no_bonus, int phase_bonus)
 		/* Skip cards without a good */
 		if (!c_ptr->num_goods) continue;
 
-		/* Assume good is available for trade */
-		trade = 1;
-
-		/* Loop over card powers */
-		for (i = 0; i < c_ptr->d_ptr->num_power; i++)
-		{
-			/* Get power pointer */
-			o_ptr = &c_ptr->d_ptr->powers[i];
-
-			/* Skip non-consume powers */
-			if (o_ptr->phase != PHASE_CONSUME) continue;
-
-			/* Check for "no trade" power */
-			if (o_ptr->code & P4_NO_TRADE) trade = 0;
-		}
+		/* Check for "no trade" power */
+		trade = !(power_info[c_ptr->d_ptr->index].code[PHASE_CONSUME] &
+		          P4_NO_TRADE);
 
 		/* Check for unavailable good */
 		if (!trade && phase_bonus) continue;
@@ -8167,6 +8934,10 @@ int good_chosen(game *g, int who, int c_idx, int o_idx, int g_list[], int num)
 			/* Remove from pool */
 			g->vp_pool -= vp * vp_mult;
 
+			/* Record points gained */
+			add_event(g, EVENT_VP, who, vp * vp_mult, g->vp_pool,
+			          0, 0);
+
 			/* Count reward */
 			p_ptr->phase_vp += vp * vp_mult;
 		}
@@ -8565,6 +9336,10 @@ int consume_hand_chosen(game *g, int who, int c_idx, int o_idx,
 			/* Remove from pool */
 			g->vp_pool -= o_ptr->value;
 
+			/* Record points gained */
+			add_event(g, EVENT_VP, who, o_ptr->value, g->vp_pool,
+			          0, 0);
+
 			/* Count reward */
 			p_ptr->phase_vp += o_ptr->value;
 		}
@@ -8696,6 +9471,9 @@ void consume_prestige_chosen(game *g, int who, int c_idx, int o_idx)
 		/* Remove from pool */
 		g->vp_pool -= vp * vp_mult;
 
+		/* Record points gained */
+		add_event(g, EVENT_VP, who, vp * vp_mult, g->vp_pool, 0, 0);
+
 		/* Count reward */
 		p_ptr->phase_vp += vp * vp_mult;
 	}
@@ -8739,7 +9517,7 @@ void consume_chosen(game *g, int who, int c_idx, int o_idx)
 	name = c_ptr->d_ptr->name;
 
 	/* Mark power as used */
-	c_ptr->misc |= 1 << (MISC_USED_SHIFT + o_idx);
+	mark_power_used(g, c_ptr, o_idx);
 
 	/* Get pointer to power */
 	o_ptr = &c_ptr->d_ptr->powers[o_idx];
@@ -8820,6 +9598,9 @@ void consume_chosen(game *g, int who, int c_idx, int o_idx)
 		/* Remove from pool */
 		g->vp_pool -= vp;
 
+		/* Record points gained */
+		add_event(g, EVENT_VP, who, vp, g->vp_pool, 0, 0);
+
 		/* Count reward */
 		p_ptr->phase_vp += vp;
 
@@ -9696,7 +10477,7 @@ void produce_chosen(game *g, int who, int c_idx, int o_idx)
 	}
 
 	/* Mark power used */
-	c_ptr->misc |= 1 << (MISC_USED_SHIFT + o_idx);
+	mark_power_used(g, c_ptr, o_idx);
 
 	/* Get name of card with power */
 	name = c_ptr->d_ptr->name;
@@ -10972,6 +11753,8 @@ int goal_minimum(int goal)
 /*
  * Check a player's progress towards a goal.
  *
+ * Most tableau criteria are read from counts kept by move_card.
+ *
  * Return zero if the player does not qualify.
  */
 static int check_goal_player(game *g, int goal, int who)
@@ -10980,7 +11763,7 @@ static int check_goal_player(game *g, int goal, int who)
 	card *c_ptr;
 	power_where w_list[100];
 	power *o_ptr;
-	int good[6], phase[6], count = 0;
+	int count = 0;
 	int i, x, n;
 
 	/* Get player pointer */
@@ -10993,35 +11776,16 @@ static int check_goal_player(game *g, int goal, int who)
 		case GOAL_FIRST_5_VP:
 
 			/* Return VP count */
-			return p_ptr->vp;
-
-		/* First to 4 good types */
-		case GOAL_FIRST_4_TYPES:
-
-			/* Clear good marks */
-			for (i = 0; i < 6; i++) good[i] = 0;
-
-			/* Start at first active card */
-			x = p_ptr->head[WHERE_ACTIVE];
-
-			/* Loop over cards */
-			for ( ; x != -1; x = g->deck[x].next)
-			{
-				/* Get card pointer */
-				c_ptr = &g->deck[x];
-
-				/* Skip non-worlds */
-				if (c_ptr->d_ptr->type != TYPE_WORLD) continue;
+			return p_ptr->vp;
 
-				/* Mark good type */
-				good[c_ptr->d_ptr->good_type] = 1;
-			}
+		/* First to 4 good types */
+		case GOAL_FIRST_4_TYPES:
 
 			/* Count types */
 			for (i = GOOD_ANY; i <= GOOD_ALIEN; i++)
 			{
 				/* Check for active type */
-				if (good[i]) count++;
+				if (p_ptr->goal_good_type[i]) count++;
 			}
 
 			/* Return number of types */
@@ -11042,44 +11806,11 @@ static int check_goal_player(game *g, int goal, int who)
 		/* First to have powers for each phase */
 		case GOAL_FIRST_PHASE_POWER:
 
-			/* Clear phase marks */
-			for (i = 0; i < 6; i++) phase[i] = 0;
-
-			/* Start at first active card */
-			x = p_ptr->head[WHERE_ACTIVE];
-
-			/* Loop over cards */
-			for ( ; x != -1; x = g->deck[x].next)
-			{
-				/* Get card pointer */
-				c_ptr = &g->deck[x];
-
-				/* Loop over card powers */
-				for (i = 0; i < c_ptr->d_ptr->num_power; i++)
-				{
-					/* Get power pointer */
-					o_ptr = &c_ptr->d_ptr->powers[i];
-
-					/* Check for trade power */
-					if (o_ptr->phase == PHASE_CONSUME &&
-					    (o_ptr->code & P4_TRADE_MASK))
-					{
-						/* XXX Mark trade power */
-						phase[0] = 1;
-					}
-					else
-					{
-						/* Mark phase */
-						phase[o_ptr->phase] = 1;
-					}
-				}
-			}
-
 			/* Count phases with powers */
 			for (i = 0; i < 6; i++)
 			{
 				/* Check for power */
-				if (phase[i]) count++;
+				if (p_ptr->goal_phase[i]) count++;
 			}
 
 			/* Return number of phases with powers */
@@ -11088,27 +11819,8 @@ static int check_goal_player(game *g, int goal, int who)
 		/* First to have a six-cost development */
 		case GOAL_FIRST_SIX_DEVEL:
 
-			/* Start at first active card */
-			x = p_ptr->head[WHERE_ACTIVE];
-
-			/* Loop over cards */
-			for ( ; x != -1; x = g->deck[x].next)
-			{
-				/* Get card pointer */
-				c_ptr = &g->deck[x];
-
-				/* Skip worlds */
-				if (c_ptr->d_ptr->type == TYPE_WORLD) continue;
-
-				/* Skip non-cost-6 cards */
-				if (c_ptr->d_ptr->cost != 6) continue;
-
-				/* Check for variable points */
-				if (c_ptr->d_ptr->num_vp_bonus) return 1;
-			}
-
-			/* No six-cost developments */
-			return 0;
+			/* Check for six-cost development */
+			return p_ptr->goal_six_devels > 0;
 
 		/* First to three Uplift cards */
 		case GOAL_FIRST_3_UPLIFT:
@@ -11147,24 +11859,8 @@ static int check_goal_player(game *g, int goal, int who)
 		/* First to have negative military or takeover power */
 		case GOAL_FIRST_NEG_MILITARY:
 
-			/* Start at first active card */
-			x = p_ptr->head[WHERE_ACTIVE];
-
-			/* Loop over cards */
-			for ( ; x != -1; x = g->deck[x].next)
-			{
-				/* Get card pointer */
-				c_ptr = &g->deck[x];
-
-				/* Skip non-worlds */
-				if (c_ptr->d_ptr->type != TYPE_WORLD) continue;
-
-				/* Count active worlds */
-				count++;
-			}
-
 			/* Check for not at least 2 worlds */
-			if (count < 2) return 0;
+			if (p_ptr->goal_worlds < 2) return 0;
 
 			/* Check for negative military */
 			if (total_military(g, who) < 0) return 1;
@@ -11223,35 +11919,17 @@ static int check_goal_player(game *g, int goal, int who)
 		/* Most blue/brown worlds (minimum 3) */
 		case GOAL_MOST_BLUE_BROWN:
 
-			/* Start at first active card */
-			x = p_ptr->head[WHERE_ACTIVE];
+			/* Count blue and brown worlds */
+			count = p_ptr->goal_good_type[GOOD_NOVELTY] +
+			        p_ptr->goal_good_type[GOOD_RARE];
 
-			/* Loop over cards */
-			for ( ; x != -1; x = g->deck[x].next)
+			/* Check for "any" kind */
+			if (g->oort_kind == GOOD_ANY ||
+			    g->oort_kind == GOOD_NOVELTY ||
+			    g->oort_kind == GOOD_RARE)
 			{
-				/* Get card pointer */
-				c_ptr = &g->deck[x];
-
-				/* Skip non-worlds */
-				if (c_ptr->d_ptr->type != TYPE_WORLD) continue;
-
-				/* Check for blue or brown */
-				if (c_ptr->d_ptr->good_type == GOOD_NOVELTY ||
-				    c_ptr->d_ptr->good_type == GOOD_RARE)
-				{
-					/* Count world */
-					count++;
-				}
-
-				/* Check for "any" kind */
-				if (c_ptr->d_ptr->good_type == GOOD_ANY &&
-				    (g->oort_kind == GOOD_ANY ||
-				     g->oort_kind == GOOD_NOVELTY ||
-				     g->oort_kind == GOOD_RARE))
-				{
-					/* Count world */
-					count++;
-				}
+				/* Count worlds */
+				count += p_ptr->goal_good_type[GOOD_ANY];
 			}
 
 			/* Return count */
@@ -11260,86 +11938,20 @@ static int check_goal_player(game *g, int goal, int who)
 		/* Most developments (minimum 4) */
 		case GOAL_MOST_DEVEL:
 
-			/* Start at first active card */
-			x = p_ptr->head[WHERE_ACTIVE];
-
-			/* Loop over cards */
-			for ( ; x != -1; x = g->deck[x].next)
-			{
-				/* Get card pointer */
-				c_ptr = &g->deck[x];
-
-				/* Skip worlds */
-				if (c_ptr->d_ptr->type == TYPE_WORLD) continue;
-
-				/* Count developments */
-				count++;
-			}
-
-			/* Return count */
-			return count;
+			/* Return number of developments */
+			return p_ptr->goal_devels;
 
 		/* Most production worlds (minimum 4) */
 		case GOAL_MOST_PRODUCTION:
 
-			/* Start at first active card */
-			x = p_ptr->head[WHERE_ACTIVE];
-
-			/* Loop over cards */
-			for ( ; x != -1; x = g->deck[x].next)
-			{
-				/* Get card pointer */
-				c_ptr = &g->deck[x];
-
-				/* Skip non-worlds */
-				if (c_ptr->d_ptr->type != TYPE_WORLD) continue;
-
-				/* Skip windfall worlds */
-				if (c_ptr->d_ptr->flags & FLAG_WINDFALL)
-					continue;
-
-				/* Skip worlds with no good type */
-				if (!c_ptr->d_ptr->good_type) continue;
-
-				/* Count world */
-				count++;
-			}
-
-			/* Return count */
-			return count;
+			/* Return number of production worlds */
+			return p_ptr->goal_production;
 
 		/* Most explore powers (minimum 3) */
 		case GOAL_MOST_EXPLORE:
 
-			/* Start at first active card */
-			x = p_ptr->head[WHERE_ACTIVE];
-
-			/* Loop over cards */
-			for ( ; x != -1; x = g->deck[x].next)
-			{
-				/* Get card pointer */
-				c_ptr = &g->deck[x];
-
-				/* Loop over card powers */
-				for (i = 0; i < c_ptr->d_ptr->num_power; i++)
-				{
-					/* Get power pointer */
-					o_ptr = &c_ptr->d_ptr->powers[i];
-
-					/* Check for explore phase */
-					if (o_ptr->phase == PHASE_EXPLORE)
-					{
-						/* Count card */
-						count++;
-
-						/* Stop looking */
-						break;
-					}
-				}
-			}
-
-			/* Return count */
-			return count;
+			/* Return number of cards with explore powers */
+			return p_ptr->goal_phase[PHASE_EXPLORE];
 
 		/* Most Rebel military worlds (minimum 3) */
 		case GOAL_MOST_REBEL:
@@ -11357,42 +11969,8 @@ static int check_goal_player(game *g, int goal, int who)
 		/* Most cards with consume powers (minimum 3) */
 		case GOAL_MOST_CONSUME:
 
-			/* Start at first active card */
-			x = p_ptr->head[WHERE_ACTIVE];
-
-			/* Loop over cards */
-			for ( ; x != -1; x = g->deck[x].next)
-			{
-				/* Get card pointer */
-				c_ptr = &g->deck[x];
-
-				/* Loop over card powers */
-				for (i = 0; i < c_ptr->d_ptr->num_power; i++)
-				{
-					/* Get power pointer */
-					o_ptr = &c_ptr->d_ptr->powers[i];
-
-					/* Check for consume phase */
-					if (o_ptr->phase == PHASE_CONSUME)
-					{
-						/* Skip trade powers */
-						if (o_ptr->code & P4_TRADE_MASK)
-						{
-							/* Skip power */
-							continue;
-						}
-
-						/* Count card */
-						count++;
-
-						/* Stop looking */
-						break;
-					}
-				}
-			}
-
-			/* Return count */
-			return count;
+			/* Return number of cards with consume powers */
+			return p_ptr->goal_phase[PHASE_CONSUME];
 	}
 
 	/* XXX */
@@ -11848,6 +12426,9 @@ static void rotate_players(game *g)
 		if (c_ptr->owner < 0) c_ptr->owner = g->num_players - 1;
 	}
 
+	/* Cached military strengths belong to other players now */
+	g->power_version++;
+
 	/* Loop over players */
 	for (i = 0; i < g->num_players; i++)
 	{
@@ -12163,7 +12744,7 @@ void begin_game(game *g)
 
 			/* XXX Move card to discard */
 			c_ptr->owner = -1;
-			c_ptr->where = WHERE_DISCARD;
+			set_where(g, start_picks[i][0], WHERE_DISCARD);
 
 			/* Card is known to player */
 			c_ptr->misc |= (1 << i);
@@ -12185,7 +12766,7 @@ void begin_game(game *g)
 
 			/* XXX Move card to discard */
 			c_ptr->owner = -1;
-			c_ptr->where = WHERE_DISCARD;
+			set_where(g, start_picks[i][1], WHERE_DISCARD);
 
 			/* Card is known to player */
 			c_ptr->misc |= (1 << i);
@@ -12281,11 +12862,8 @@ void begin_game(game *g)
 		/* Loop over start worlds */
 		for (i = 0; i < num_start; i++)
 		{
-			/* Get card pointer for start world */
-			c_ptr = &g->deck[start[i]];
-
 			/* Temporarily move card to discard pile */
-			c_ptr->where = WHERE_DISCARD;
+			set_where(g, start[i], WHERE_DISCARD);
 		}
 
 		/* Loop over players */
@@ -12326,11 +12904,8 @@ void begin_game(game *g)
 		/* Loop over remaining start worlds */
 		for (i = 0; i < num_start; i++)
 		{
-			/* Get card pointer for start world */
-			c_ptr = &g->deck[start[i]];
-
 			/* Move card back to deck */
-			c_ptr->where = WHERE_DECK;
+			set_where(g, start[i], WHERE_DECK);
 		}
 
 		/* Loop over players again */
@@ -12567,6 +13142,9 @@ int game_round(game *g)
 	/* Check for aborted game */
 	if (g->game_over) return 0;
 
+	/* Record start of round */
+	add_event(g, EVENT_ROUND, -1, g->round, 0, 0, 0);
+
 	/* Message */
 	if (!g->simulation)
 	{
@@ -12751,6 +13329,9 @@ int game_round(game *g)
 		/* Skip unchosen phases */
 		if (!g->action_selected[i]) continue;
 
+		/* Record start of phase */
+		add_event(g, EVENT_PHASE, -1, i, 0, 0, 0);
+
 		/* Check for real game */
 		if (!g->simulation)
 		{
@@ -12884,54 +13465,11 @@ int game_round(game *g)
  */
 int total_military(game *g, int who)
 {
-	power_where w_list[100];
-	power *o_ptr;
-	int i, n, amt = 0;
-
-	/* Get list of settle powers */
-	n = get_powers(g, who, PHASE_SETTLE, w_list);
-
-	/* Loop over powers */
-	for (i = 0; i < n; i++)
-	{
-		/* Get power pointer */
-		o_ptr = w_list[i].o_ptr;
-
-		/* Check for non-specific military */
-		if (o_ptr->code == P3_EXTRA_MILITARY)
-		{
-			/* Add to military */
-			amt += o_ptr->value;
-		}
-
-		/* Check for non-specific military per military world */
-		if (o_ptr->code == (P3_EXTRA_MILITARY | P3_PER_MILITARY))
-		{
-			/* Add to military */
-			amt += count_active_flags(g, who, FLAG_MILITARY);
-		}
-
-		/* Check for non-specific military per chromosome flag */
-		if (o_ptr->code == (P3_EXTRA_MILITARY | P3_PER_CHROMO))
-		{
-			/* Add to military */
-			amt += count_active_flags(g, who, FLAG_CHROMO);
-		}
+	/* Compute military strength if needed */
+	update_military(g, who);
 
-		/* Check for only if Imperium card active */
-		if (o_ptr->code == (P3_EXTRA_MILITARY | P3_IF_IMPERIUM))
-		{
-			/* Check for Imperium flag */
-			if (count_active_flags(g, who, FLAG_IMPERIUM))
-			{
-				/* Add power's value */
-				amt += o_ptr->value;
-			}
-		}
-	}
-
-	/* Return amount of military */
-	return amt;
+	/* Return non-specific military */
+	return g->p[who].mil_total;
 }
 
 /*
@@ -12999,18 +13537,9 @@ static int bonus_match(game *g, vp_bonus *v_ptr, design *d_ptr)
 			if (d_ptr->type == TYPE_DEVELOPMENT &&
 			    type == VP_WORLD_EXPLORE) return 0;
 
-			/* Loop over powers */
-			for (i = 0; i < d_ptr->num_power; i++)
-			{
-				/* Get power pointer */
-				o_ptr = &d_ptr->powers[i];
-
-				/* Check for explore power */
-				if (o_ptr->phase == PHASE_EXPLORE) return 1;
-			}
-
-			/* No explore powers */
-			return 0;
+			/* Check for explore powers */
+			return (power_info[d_ptr->index].phase_mask >>
+			        PHASE_EXPLORE) & 1;
 
 		/* Trade/Consume powers */
 		case VP_DEVEL_TRADE:
@@ -13177,12 +13706,13 @@ static int bonus_match(game *g, vp_bonus *v_ptr, design *d_ptr)
 }
 
 /*
- * Get score bonuses from given card.
+ * Get score bonuses from given card design that do not depend on matching
+ * single cards, such as bonuses for VP chips or military.
  */
-int get_score_bonus(game *g, int who, int which)
+static int get_state_bonus(game *g, int who, design *score)
 {
 	player *p_ptr;
-	card *c_ptr, *score;
+	card *c_ptr;
 	vp_bonus *v_ptr;
 	int i, j, x, count = 0, types[6];
 	int amt = 0;
@@ -13190,14 +13720,11 @@ int get_score_bonus(game *g, int who, int which)
 	/* Get player pointer */
 	p_ptr = &g->p[who];
 
-	/* Get scoring card pointer */
-	score = &g->deck[which];
-
 	/* Loop over bonuses */
-	for (i = 0; i < score->d_ptr->num_vp_bonus; i++)
+	for (i = 0; i < score->num_vp_bonus; i++)
 	{
 		/* Get VP bonus pointer */
-		v_ptr = &score->d_ptr->bonuses[i];
+		v_ptr = &score->bonuses[i];
 
 		/* Check for simple bonuses */
 		if (v_ptr->type == VP_THREE_VP)
@@ -13269,31 +13796,36 @@ int get_score_bonus(game *g, int who, int which)
 		}
 	}
 
+	/* Return total bonus */
+	return amt;
+}
+
+/*
+ * Get score bonuses from given card.
+ */
+int get_score_bonus(game *g, int who, int which)
+{
+	player *p_ptr;
+	card *score;
+	int x, amt;
+
+	/* Get player pointer */
+	p_ptr = &g->p[who];
+
+	/* Get scoring card pointer */
+	score = &g->deck[which];
+
+	/* Start with bonuses from game state */
+	amt = get_state_bonus(g, who, score->d_ptr);
+
 	/* Start at first active card */
 	x = p_ptr->head[WHERE_ACTIVE];
 
 	/* Loop over active cards */
 	for ( ; x != -1; x = g->deck[x].next)
 	{
-		/* Get card pointer */
-		c_ptr = &g->deck[x];
-
-		/* Loop over scoring card's bonuses */
-		for (i = 0; i < score->d_ptr->num_vp_bonus; i++)
-		{
-			/* Get bonus pointer */
-			v_ptr = &score->d_ptr->bonuses[i];
-
-			/* Check for match against current power */
-			if (bonus_match(g, v_ptr, c_ptr->d_ptr))
-			{
-				/* Add score */
-				amt += v_ptr->point;
-
-				/* Skip remaining bonuses */
-				break;
-			}
-		}
+		/* Add bonus for card */
+		amt += bonus_card_vp(g, score->d_ptr, g->deck[x].d_ptr);
 	}
 
 	/* Return total bonus */
@@ -13307,7 +13839,9 @@ static void score_game_player(game *g, int who)
 {
 	player *p_ptr = &g->p[who];
 	card *c_ptr;
-	int i, x, count;
+	design *d_ptr;
+	int s_list[MAX_DECK], u_list[MAX_DECK], num_s = 0, num_u = 0;
+	int i, j, x, count;
 
 	/* Reset goal vp */
 	p_ptr->goal_vp = 0;
@@ -13315,6 +13849,9 @@ static void score_game_player(game *g, int who)
 	/* Start with VP chips */
 	p_ptr->end_vp = p_ptr->vp;
 
+	/* Add cached points from cards and matched bonuses */
+	p_ptr->end_vp += p_ptr->card_vp + p_ptr->bonus_vp;
+
 	/* Start at first active card */
 	x = p_ptr->head[WHERE_ACTIVE];
 
@@ -13324,17 +13861,57 @@ static void score_game_player(game *g, int who)
 		/* Get card pointer */
 		c_ptr = &g->deck[x];
 
-		/* Add points from card */
-		p_ptr->end_vp += c_ptr->d_ptr->vp;
+		/* Remember cards with uncached matches */
+		if (bonus_uncached(c_ptr->d_ptr)) u_list[num_u++] = x;
+
+		/* Skip cards without VP bonuses */
+		if (!c_ptr->d_ptr->num_vp_bonus) continue;
+
+		/* Remember scoring card */
+		s_list[num_s++] = x;
+
+		/* Add bonuses from game state */
+		p_ptr->end_vp += get_state_bonus(g, who, c_ptr->d_ptr);
+	}
+
+	/* Loop over scoring cards */
+	for (i = 0; i < num_s; i++)
+	{
+		/* Get scoring card's design */
+		d_ptr = g->deck[s_list[i]].d_ptr;
 
-		/* Check for VP bonuses */
-		if (c_ptr->d_ptr->num_vp_bonus)
+		/* Loop over cards with uncached matches */
+		for (j = 0; j < num_u; j++)
 		{
-			/* Add in bonuses */
-			p_ptr->end_vp += get_score_bonus(g, who, x);
+			/* Add bonus for card */
+			p_ptr->end_vp += bonus_card_vp(g, d_ptr,
+			                               g->deck[u_list[j]].d_ptr);
 		}
 	}
 
+#ifdef DEBUG
+	/* Start with VP chips */
+	count = p_ptr->vp;
+
+	/* Recompute points from all active cards */
+	for (x = p_ptr->head[WHERE_ACTIVE]; x != -1; x = g->deck[x].next)
+	{
+		/* Add printed points */
+		count += g->deck[x].d_ptr->vp;
+
+		/* Add bonuses */
+		if (g->deck[x].d_ptr->num_vp_bonus)
+			count += get_score_bonus(g, who, x);
+	}
+
+	/* Check for mismatch */
+	if (count != p_ptr->end_vp)
+	{
+		/* Error */
+		printf("Bad cached card score!\n");
+	}
+#endif
+
 	/* Loop over "first" goals */
 	for (i = GOAL_FIRST_5_VP; i <= GOAL_FIRST_4_MILITARY; i++)
 	{
@@ -13586,6 +14163,14 @@ void declare_winner(game *g)
 		p_ptr->winner = 1;
 	}
 
+	/* Loop over players */
+	for (i = 0; i < g->num_players; i++)
+	{
+		/* Record final score */
+		add_event(g, EVENT_GAME_OVER, i, g->p[i].end_vp,
+		          g->p[i].winner, 0, 0);
+	}
+
 	/* Check for simulation */
 	if (!g->simulation)
 	{
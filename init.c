@@ -32,6 +32,11 @@ int num_design;
  */
 design library[AVAILABLE_DESIGN];
 
+/*
+ * Power summaries of card designs.
+ */
+power_table power_info[AVAILABLE_DESIGN];
+
 /*
  * Campaign library.
  */
@@ -314,6 +319,45 @@ static uint64_t lookup_power(char *ptr, int phase)
 	exit(1);
 }
 
+/*
+ * Build the power summary of each loaded design.
+ */
+static void build_power_tables(void)
+{
+	design *d_ptr;
+	power_table *t_ptr;
+	power *o_ptr;
+	int i, j;
+
+	/* Clear summaries */
+	memset(power_info, 0, sizeof(power_info));
+
+	/* Loop over designs */
+	for (i = 0; i < num_design; i++)
+	{
+		/* Get design and summary pointers */
+		d_ptr = &library[i];
+		t_ptr = &power_info[i];
+
+		/* Loop over powers */
+		for (j = 0; j < d_ptr->num_power; j++)
+		{
+			/* Get power pointer */
+			o_ptr = &d_ptr->powers[j];
+
+			/* Mark phase */
+			t_ptr->phase_mask |= 1 << o_ptr->phase;
+
+			/* Add code to phase */
+			t_ptr->code[o_ptr->phase] |= o_ptr->code;
+
+			/* Add power to phase's list */
+			t_ptr->index[o_ptr->phase][t_ptr->num[o_ptr->phase]] = j;
+			t_ptr->num[o_ptr->phase]++;
+		}
+	}
+}
+
 /*
  * Read card designs from 'cards.txt' file.
  */
@@ -582,6 +626,9 @@ int read_cards(char *suggestion)
 	/* Close card design file */
 	fclose(fff);
 
+	/* Summarize powers of designs */
+	build_power_tables();
+
 	/* Success */
 	return 0;
 }
@@ -980,6 +1027,9 @@ void init_game(game *g)
 	/* Game is not simulated */
 	g->simulation = 0;
 
+	/* No event log until the owner starts one */
+	g->events = NULL;
+
 	/* Set size of VP pool */
 	g->vp_pool = g->num_players * 12;
 
@@ -1067,6 +1117,12 @@ void init_game(game *g)
 		}
 	}
 
+	/* All cards start in draw pile */
+	rebuild_piles(g);
+
+	/* Start power version */
+	g->power_version = 1;
+
 	/* Loop over players */
 	for (i = 0; i < g->num_players; i++)
 	{
@@ -1104,6 +1160,9 @@ void init_game(game *g)
 			p_ptr->start_head[j] = -1;
 		}
 
+		/* Clear sets of cards */
+		clear_card_sets(p_ptr);
+
 		/* Player has no bonus military accrued */
 		p_ptr->bonus_military = 0;
 
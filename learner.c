@@ -143,6 +143,21 @@ int main(int argc, char *argv[])
 			/* Set factor */
 			factor = atof(argv[++i]);
 		}
+
+		/* Check for dataset to record */
+		else if (!strcmp(argv[i], "-d"))
+		{
+			/* Open dataset for appending */
+			ai_record = fopen(argv[++i], "ab");
+
+			/* Check for failure */
+			if (!ai_record)
+			{
+				/* Error */
+				perror(argv[i]);
+				exit(1);
+			}
+		}
 	}
 
 	/* Set number of players */
@@ -242,6 +257,9 @@ int main(int argc, char *argv[])
 		my_game.p[i].control->shutdown(&my_game, i);
 	}
 
+	/* Close recorded dataset */
+	if (ai_record) fclose(ai_record);
+
 	/* Done */
 	return 0;
 }
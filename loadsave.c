@@ -94,6 +94,9 @@ static int read_game(game *g, FILE* fff)
 	/* Clear simulation flag */
 	g->simulation = 0;
 
+	/* No event log until the owner starts one */
+	g->events = NULL;
+
 	/* Read current round number (added in later version, might not exist) */
 	int round_temp = 1; /* Default to round 1 for backwards compatibility */
 	if (fscanf(fff, "%d\n", &round_temp) != 1)
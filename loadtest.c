@@ -0,0 +1,1246 @@
+/*
+ * Race for the Galaxy AI
+ *
+ * Copyright (C) 2009-2011 Keldon Jones
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Server load generator.
+ *
+ * Opens a number of simulated client connections to a server, logs them
+ * in, and has them create, join and play games against each other.  The
+ * lobby traffic is generated here, while each game seat is played by an
+ * ai_client process, exactly like the server's own A.I. seats.  We relay
+ * messages between the server and the ai_client, holding answers back for
+ * a configurable think time and timing the server's replies.
+ *
+ * Every simulated client creates a user, so the server should be run
+ * locally, either against a scratch database (see the server's -d option)
+ * or built with the stand-in database in dbstub.c.  "make server-stub
+ * ai_client loadtest" builds all three programs.
+ *
+ * Latency is the time from sending a request until the server's reply to
+ * it arrives: HELLO for a login, JOINACK for a create or join, START for
+ * a start, and for a game answer the next question or the waiting status
+ * that shows our seat is no longer waited on.
+ */
+
+#include "rftg.h"
+#include "comm.h"
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+/*
+ * Simulated client states.
+ */
+#define LS_LOGIN     0
+#define LS_LOBBY     1
+#define LS_JOINING   2
+#define LS_JOINED    3
+#define LS_PLAYING   4
+#define LS_DONE      5
+
+/*
+ * Latency sample kinds.
+ */
+#define LAT_LOBBY    0
+#define LAT_GAME     1
+#define MAX_LAT      2
+
+/*
+ * Size of buffers for messages read from the server or ai_client.
+ */
+#define LOAD_BUF_SIZE 65536
+
+/*
+ * A simulated client.
+ */
+typedef struct sim_client
+{
+	/* Connection to server */
+	int fd;
+
+	/* Connection to ai_client playing our seat, or -1 */
+	int ai_fd;
+
+	/* Process ID of ai_client */
+	pid_t ai_pid;
+
+	/* Client state */
+	int state;
+
+	/* Game group we belong to */
+	int group;
+
+	/* Our seat in the current game */
+	int seat;
+
+	/* Data read from server */
+	char buf[LOAD_BUF_SIZE];
+	int buf_full;
+
+	/* Data read from ai_client */
+	char ai_buf[LOAD_BUF_SIZE];
+	int ai_full;
+
+	/* Answers from ai_client waiting for think time to pass */
+	char *pend;
+	int pend_len, pend_size;
+
+	/* Time to release waiting answers */
+	double pend_time;
+
+	/* Time and kind of last request awaiting a server reply */
+	double sent_time;
+	int sent_kind;
+
+	/* Type of reply expected to a lobby request */
+	int sent_reply;
+
+	/* Number of games finished */
+	int games;
+
+} sim_client;
+
+/*
+ * A group of simulated clients playing games together.
+ */
+typedef struct sim_group
+{
+	/* First client in group (the game creator) */
+	int first;
+
+	/* Session ID of current game */
+	int sid;
+
+	/* Number of members joined or back in lobby */
+	int ready;
+
+	/* Time current game started */
+	double start_time;
+
+} sim_group;
+
+/*
+ * Simulated clients and groups.
+ */
+static sim_client *sims;
+static sim_group *groups;
+static int num_sim, num_group;
+
+/*
+ * Settings.
+ */
+static char *server_host = "localhost";
+static int server_port = 16309;
+static int num_players = 3;
+static int expansion = 0;
+static int num_games = 1;
+static int think_time = 0;
+static char *user_prefix = "load";
+static char *ai_path = "./ai_client";
+static int server_pid = 0;
+
+/*
+ * Latency samples (in seconds).
+ */
+static double *lat[MAX_LAT];
+static int lat_num[MAX_LAT], lat_max[MAX_LAT];
+
+/*
+ * Counts of messages, bytes and games.
+ */
+static long msg_recv, msg_sent, bytes_recv;
+static int games_done;
+
+/*
+ * Total length of finished games.
+ */
+static double game_time;
+
+/*
+ * Return the current time in seconds.
+ */
+static double now(void)
+{
+	struct timeval tv;
+
+	/* Get time of day */
+	gettimeofday(&tv, NULL);
+
+	/* Convert to seconds */
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+/*
+ * Return the CPU time used by the server so far, in seconds.
+ *
+ * Return -1 if unknown.
+ */
+static double server_cpu(void)
+{
+	FILE *fff;
+	char text[1024], *ptr;
+	unsigned long utime, stime;
+
+	/* Check for no server process given */
+	if (!server_pid) return -1;
+
+	/* Open process status */
+	sprintf(text, "/proc/%d/stat", server_pid);
+	fff = fopen(text, "r");
+
+	/* Check for failure */
+	if (!fff) return -1;
+
+	/* Read status line */
+	if (!fgets(text, 1024, fff)) text[0] = '\0';
+
+	/* Close file */
+	fclose(fff);
+
+	/* Skip past process name */
+	ptr = strrchr(text, ')');
+
+	/* Check for bad format */
+	if (!ptr) return -1;
+
+	/* Read user and system times (fields 14 and 15) */
+	if (sscanf(ptr + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u "
+	                    "%lu %lu", &utime, &stime) != 2) return -1;
+
+	/* Convert clock ticks to seconds */
+	return (double)(utime + stime) / sysconf(_SC_CLK_TCK);
+}
+
+/*
+ * Add a latency sample.
+ */
+static void add_latency(int kind, double x)
+{
+	/* Check for full list */
+	if (lat_num[kind] == lat_max[kind])
+	{
+		/* Grow list */
+		lat_max[kind] = 2 * lat_max[kind] + 1024;
+		lat[kind] = (double *)realloc(lat[kind],
+		                              sizeof(double) * lat_max[kind]);
+	}
+
+	/* Add sample */
+	lat[kind][lat_num[kind]++] = x;
+}
+
+/*
+ * Compare two latency samples.
+ */
+static int cmp_latency(const void *a, const void *b)
+{
+	double x = *(double *)a, y = *(double *)b;
+
+	/* Compare */
+	return (x > y) - (x < y);
+}
+
+/*
+ * Send message to server.
+ */
+void send_msg(int fd, char *msg)
+{
+	int size, sent = 0, x;
+	char *ptr;
+
+	/* Go to size area of message */
+	ptr = msg + 4;
+
+	/* Read size */
+	size = get_integer(&ptr);
+
+	/* Send until finished */
+	while (sent < size)
+	{
+		/* Write as much as possible */
+		x = write(fd, msg + sent, size - sent);
+
+		/* Check for errors */
+		if (x < 0)
+		{
+			/* Check for broken pipe */
+			if (errno == EPIPE) return;
+
+			/* Error */
+			perror("send");
+			return;
+		}
+
+		/* Count bytes sent */
+		sent += x;
+	}
+}
+
+/*
+ * Note that a lobby request was sent for a simulated client, and start
+ * timing the server's reply of the given type.
+ */
+static void sim_sent(int n, int reply)
+{
+	/* Count message */
+	msg_sent++;
+
+	/* Remember request */
+	sims[n].sent_time = now();
+	sims[n].sent_kind = LAT_LOBBY;
+	sims[n].sent_reply = reply;
+}
+
+/*
+ * Check whether a message from the server answers a simulated client's
+ * outstanding request.
+ */
+static int is_reply(int n, int type, char *ptr)
+{
+	sim_client *s_ptr = &sims[n];
+	int i, x = -1;
+
+	/* Check for lobby request */
+	if (s_ptr->sent_kind == LAT_LOBBY) return type == s_ptr->sent_reply;
+
+	/* Next question to us is a reply */
+	if (type == MSG_CHOOSE) return 1;
+
+	/* Other messages are not, except waiting status */
+	if (type != MSG_WAITING) return 0;
+
+	/* Loop over seats up to ours */
+	for (i = 0; i <= s_ptr->seat; i++)
+	{
+		/* Read seat's status */
+		x = get_integer(&ptr);
+	}
+
+	/* Reply if we are no longer waited on */
+	return x == WAIT_READY;
+}
+
+/*
+ * Create a new game for a group.
+ */
+static void create_game(int g)
+{
+	sim_client *s_ptr = &sims[groups[g].first];
+	char desc[1024];
+
+	/* Format game description */
+	sprintf(desc, "%s %d", user_prefix, g);
+
+	/* Send create message */
+	send_msgf(s_ptr->fd, MSG_CREATE, "ssddddddd", "", desc,
+	          num_players, num_players, expansion, 0, 0, 0, 0);
+
+	/* Start timing reply */
+	sim_sent(groups[g].first, MSG_JOINACK);
+
+	/* Creator is joining */
+	s_ptr->state = LS_JOINING;
+
+	/* No members have joined yet */
+	groups[g].ready = 0;
+}
+
+/*
+ * Start an ai_client process to play our seat.
+ */
+static void start_ai(int n)
+{
+	sim_client *s_ptr = &sims[n];
+	int fds[2];
+
+	/* Create socket pair */
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0)
+	{
+		/* Error */
+		perror("socketpair");
+		exit(1);
+	}
+
+	/* Fork process */
+	s_ptr->ai_pid = fork();
+
+	/* Check for error */
+	if (s_ptr->ai_pid < 0)
+	{
+		/* Error */
+		perror("fork");
+		exit(1);
+	}
+
+	/* Check for child */
+	if (!s_ptr->ai_pid)
+	{
+		/* Use socket as standard input */
+		dup2(fds[1], 0);
+
+		/* Close other socket ends */
+		close(fds[0]);
+		close(fds[1]);
+
+		/* Run A.I. client */
+		execl(ai_path, "ai_client", NULL);
+
+		/* Error */
+		perror("execl");
+		exit(1);
+	}
+
+	/* Close child's end */
+	close(fds[1]);
+
+	/* Keep later ai_clients from holding our end open */
+	fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+
+	/* Save our end */
+	s_ptr->ai_fd = fds[0];
+	s_ptr->ai_full = 0;
+	s_ptr->pend_len = 0;
+}
+
+/*
+ * Stop talking to our ai_client.
+ */
+static void stop_ai(int n)
+{
+	sim_client *s_ptr = &sims[n];
+
+	/* Check for no A.I. */
+	if (s_ptr->ai_fd < 0) return;
+
+	/* Close connection (the client exits) */
+	close(s_ptr->ai_fd);
+	s_ptr->ai_fd = -1;
+
+	/* Collect process */
+	waitpid(s_ptr->ai_pid, NULL, 0);
+
+	/* Discard waiting answers */
+	s_ptr->pend_len = 0;
+}
+
+/*
+ * Report an ai_client that exited in the middle of a game and stop.
+ *
+ * The server would otherwise wait for the seat's answers until it times
+ * out and hands the seat to its own A.I.
+ */
+static void ai_died(int n)
+{
+	sim_client *s_ptr = &sims[n];
+	int status;
+
+	/* Close connection */
+	close(s_ptr->ai_fd);
+	s_ptr->ai_fd = -1;
+
+	/* Collect process */
+	waitpid(s_ptr->ai_pid, &status, 0);
+
+	/* Check for killed by signal */
+	if (WIFSIGNALED(status))
+	{
+		/* Print signal */
+		printf("A.I. for %s%d killed by signal %d\n", user_prefix, n,
+		       WTERMSIG(status));
+	}
+	else
+	{
+		/* Print exit status */
+		printf("A.I. for %s%d exited with status %d\n", user_prefix, n,
+		       WEXITSTATUS(status));
+	}
+
+	/* Stop */
+	exit(1);
+}
+
+/*
+ * Forward a message from the server to our ai_client.
+ */
+static void forward_ai(int n, char *msg, int size)
+{
+	sim_client *s_ptr = &sims[n];
+	int sent = 0, x;
+
+	/* Check for no A.I. */
+	if (s_ptr->ai_fd < 0) return;
+
+	/* Send until finished */
+	while (sent < size)
+	{
+		/* Write as much as possible */
+		x = write(s_ptr->ai_fd, msg + sent, size - sent);
+
+		/* Check for error */
+		if (x < 0)
+		{
+			/* A.I. has gone away */
+			ai_died(n);
+		}
+
+		/* Count bytes sent */
+		sent += x;
+	}
+}
+
+/*
+ * Handle a message from the server to a simulated client.
+ */
+static void server_message(int n, char *msg)
+{
+	sim_client *s_ptr = &sims[n];
+	sim_group *g_ptr = &groups[s_ptr->group];
+	char text[1024], *ptr = msg;
+	int type, size, i;
+
+	/* Read message type and size */
+	type = get_integer(&ptr);
+	size = get_integer(&ptr);
+
+	/* Count message */
+	msg_recv++;
+	bytes_recv += size;
+
+	/* Check for reply to request */
+	if (s_ptr->sent_time > 0 && is_reply(n, type, ptr))
+	{
+		/* Add latency sample */
+		add_latency(s_ptr->sent_kind, now() - s_ptr->sent_time);
+
+		/* Request answered */
+		s_ptr->sent_time = 0;
+	}
+
+	/* Check message type */
+	switch (type)
+	{
+		/* Login accepted */
+		case MSG_HELLO:
+
+			/* Client is in lobby */
+			s_ptr->state = LS_LOBBY;
+
+			/* Count members in lobby */
+			g_ptr->ready++;
+
+			/* Check for whole group logged in */
+			if (g_ptr->ready == num_players) create_game(s_ptr->group);
+			break;
+
+		/* Login denied */
+		case MSG_DENIED:
+
+			/* Read reason */
+			get_string(text, &ptr);
+
+			/* Print reason and exit */
+			printf("Login denied: %s\n", text);
+			exit(1);
+
+		/* Server disconnect */
+		case MSG_GOODBYE:
+
+			/* Read reason */
+			get_string(text, &ptr);
+
+			/* Print reason and exit */
+			printf("Server disconnected: %s\n", text);
+			exit(1);
+
+		/* Ping from server */
+		case MSG_PING:
+
+			/* Reply */
+			send_msgf(s_ptr->fd, MSG_PING, "");
+			break;
+
+		/* Joined game */
+		case MSG_JOINACK:
+
+			/* Check for creator */
+			if (n == g_ptr->first)
+			{
+				/* Remember session */
+				g_ptr->sid = get_integer(&ptr);
+
+				/* Loop over other members */
+				for (i = 1; i < num_players; i++)
+				{
+					/* Ask to join */
+					send_msgf(sims[g_ptr->first + i].fd,
+					          MSG_JOIN, "ds", g_ptr->sid, "");
+					sim_sent(g_ptr->first + i,
+					         MSG_JOINACK);
+
+					/* Member is joining */
+					sims[g_ptr->first + i].state =
+					                           LS_JOINING;
+				}
+			}
+
+			/* Client has joined */
+			s_ptr->state = LS_JOINED;
+
+			/* Count joined members */
+			g_ptr->ready++;
+
+			/* Check for everyone joined */
+			if (g_ptr->ready == num_players)
+			{
+				/* Start game */
+				send_msgf(sims[g_ptr->first].fd, MSG_START,
+				          "d", g_ptr->sid);
+				sim_sent(g_ptr->first, MSG_START);
+
+				/* Members must come back to lobby later */
+				g_ptr->ready = 0;
+			}
+			break;
+
+		/* Join denied */
+		case MSG_JOINNAK:
+
+			/* Read reason */
+			get_string(text, &ptr);
+
+			/* Print reason and exit */
+			printf("Join denied: %s\n", text);
+			exit(1);
+
+		/* Game has started */
+		case MSG_START:
+
+			/* Client is playing */
+			s_ptr->state = LS_PLAYING;
+
+			/* Start A.I. for our seat */
+			start_ai(n);
+
+			/* Remember game start */
+			if (n == g_ptr->first) g_ptr->start_time = now();
+			break;
+
+		/* Seat assignment */
+		case MSG_SEAT:
+
+			/* Remember seat */
+			s_ptr->seat = get_integer(&ptr);
+
+			/* Pass to A.I. */
+			forward_ai(n, msg, size);
+			break;
+
+		/* Game messages */
+		case MSG_STATUS_META:
+		case MSG_STATUS_PLAYER:
+		case MSG_STATUS_CARD:
+		case MSG_STATUS_GOAL:
+		case MSG_STATUS_MISC:
+		case MSG_LOG:
+		case MSG_LOG_FORMAT:
+		case MSG_GAMECHAT:
+		case MSG_WAITING:
+		case MSG_CHOOSE:
+		case MSG_PREPARE:
+
+			/* Pass to A.I. */
+			forward_ai(n, msg, size);
+			break;
+
+		/* Game is over */
+		case MSG_GAMEOVER:
+
+			/* Stop A.I. */
+			stop_ai(n);
+
+			/* Acknowledge and return to lobby */
+			send_msgf(s_ptr->fd, MSG_GAMEOVER, "");
+			msg_sent++;
+
+			/* Count game */
+			s_ptr->games++;
+
+			/* Check for creator */
+			if (n == g_ptr->first)
+			{
+				/* Count finished game */
+				games_done++;
+
+				/* Add to game time */
+				game_time += now() - g_ptr->start_time;
+			}
+
+			/* Check for more games to play */
+			if (s_ptr->games < num_games)
+			{
+				/* Client is in lobby */
+				s_ptr->state = LS_LOBBY;
+
+				/* Count members back in lobby */
+				g_ptr->ready++;
+
+				/* Check for whole group back */
+				if (g_ptr->ready == num_players)
+				{
+					/* Create next game */
+					create_game(s_ptr->group);
+				}
+			}
+			else
+			{
+				/* Client is done */
+				s_ptr->state = LS_DONE;
+			}
+			break;
+
+		/* Unneeded message types */
+		default:
+			break;
+	}
+}
+
+/*
+ * Handle a message from a client's ai_client.
+ *
+ * Answers are queued until the think time has passed.
+ */
+static void ai_message(int n, char *msg, int size)
+{
+	sim_client *s_ptr = &sims[n];
+
+	/* Check for no answers already waiting */
+	if (!s_ptr->pend_len)
+	{
+		/* Pick release time */
+		s_ptr->pend_time = now();
+
+		/* Add think time, varied by up to half */
+		if (think_time > 0)
+		{
+			/* Add think time */
+			s_ptr->pend_time += (think_time / 2 +
+			                     rand() % (think_time + 1)) / 1000.0;
+		}
+	}
+
+	/* Check for insufficient room */
+	if (s_ptr->pend_len + size > s_ptr->pend_size)
+	{
+		/* Grow buffer */
+		s_ptr->pend_size = 2 * s_ptr->pend_size + size + 1024;
+		s_ptr->pend = (char *)realloc(s_ptr->pend, s_ptr->pend_size);
+	}
+
+	/* Add answer */
+	memcpy(s_ptr->pend + s_ptr->pend_len, msg, size);
+	s_ptr->pend_len += size;
+}
+
+/*
+ * Send answers whose think time has passed.
+ */
+static void release_answers(int n, double cur)
+{
+	sim_client *s_ptr = &sims[n];
+	char *ptr;
+	int pos = 0, size;
+
+	/* Check for nothing to send or still thinking */
+	if (!s_ptr->pend_len || cur < s_ptr->pend_time) return;
+
+	/* Loop over waiting messages */
+	while (pos < s_ptr->pend_len)
+	{
+		/* Read message size */
+		ptr = s_ptr->pend + pos + 4;
+		size = get_integer(&ptr);
+
+		/* Send message */
+		send_msg(s_ptr->fd, s_ptr->pend + pos);
+
+		/* Count message */
+		msg_sent++;
+
+		/* Advance to next message */
+		pos += size;
+	}
+
+	/* Clear waiting answers */
+	s_ptr->pend_len = 0;
+
+	/* Start timing server reply */
+	s_ptr->sent_time = cur;
+	s_ptr->sent_kind = LAT_GAME;
+}
+
+/*
+ * Read available data from a connection and handle complete messages.
+ *
+ * Return 0 if the connection was closed.
+ */
+static int read_data(int n, int fd, char *buf, int *full, int from_ai)
+{
+	char *ptr;
+	int x, pos = 0;
+
+	/* Read as much as possible */
+	x = read(fd, buf + *full, LOAD_BUF_SIZE - *full);
+
+	/* Check for closed connection or error */
+	if (x <= 0)
+	{
+		/* Check for try again */
+		if (x < 0 && errno == EAGAIN) return 1;
+
+		/* Connection closed */
+		return 0;
+	}
+
+	/* Add to amount read */
+	*full += x;
+
+	/* Loop over complete messages */
+	while (*full - pos >= 8)
+	{
+		/* Read message size */
+		ptr = buf + pos + 4;
+		x = get_integer(&ptr);
+
+		/* Check for bad message size */
+		if (x < 8 || x > LOAD_BUF_SIZE)
+		{
+			/* Error */
+			printf("Got bad message size %d\n", x);
+			exit(1);
+		}
+
+		/* Stop at incomplete message */
+		if (*full - pos < x) break;
+
+		/* Handle message */
+		if (from_ai) ai_message(n, buf + pos, x);
+		else server_message(n, buf + pos);
+
+		/* Advance to next message */
+		pos += x;
+
+		/* Stop if A.I. connection was closed while handling */
+		if (from_ai && sims[n].ai_fd < 0) return 1;
+	}
+
+	/* Move leftover data to start of buffer */
+	memmove(buf, buf + pos, *full - pos);
+	*full -= pos;
+
+	/* Connection still open */
+	return 1;
+}
+
+/*
+ * Connect a simulated client to the server and log in.
+ */
+static void connect_sim(int n)
+{
+	sim_client *s_ptr = &sims[n];
+	struct hostent *server_host_ent;
+	struct sockaddr_in server_addr;
+	char user[1024];
+
+	/* Look up server */
+	server_host_ent = gethostbyname(server_host);
+
+	/* Check for error */
+	if (!server_host_ent)
+	{
+		/* Error */
+		printf("Failed to lookup %s\n", server_host);
+		exit(1);
+	}
+
+	/* Create socket */
+	s_ptr->fd = socket(AF_INET, SOCK_STREAM, 0);
+
+	/* Check for error */
+	if (s_ptr->fd < 0)
+	{
+		/* Error */
+		perror("socket");
+		exit(1);
+	}
+
+	/* Set server address */
+	memset(&server_addr, 0, sizeof(struct sockaddr_in));
+	server_addr.sin_family = AF_INET;
+	memcpy(&server_addr.sin_addr.s_addr, server_host_ent->h_addr,
+	       server_host_ent->h_length);
+	server_addr.sin_port = htons(server_port);
+
+	/* Connect */
+	if (connect(s_ptr->fd, (struct sockaddr *)&server_addr,
+	            sizeof(struct sockaddr_in)) < 0)
+	{
+		/* Error */
+		perror("connect");
+		exit(1);
+	}
+
+	/* Keep ai_clients from holding connection open */
+	fcntl(s_ptr->fd, F_SETFD, FD_CLOEXEC);
+
+	/* No A.I. running */
+	s_ptr->ai_fd = -1;
+
+	/* Create user name */
+	sprintf(user, "%s%d", user_prefix, n);
+
+	/* Send login message */
+	send_msgf(s_ptr->fd, MSG_LOGIN, "ssss", user, "load", VERSION,
+	          RELEASE);
+	sim_sent(n, MSG_HELLO);
+
+	/* Client is logging in */
+	s_ptr->state = LS_LOGIN;
+}
+
+/*
+ * Print latency percentiles for one kind of request.
+ */
+static void report_latency(char *name, int kind)
+{
+	double *l = lat[kind];
+	int num = lat_num[kind];
+
+	/* Check for no samples */
+	if (!num)
+	{
+		/* Print empty line */
+		printf("%s latency: no samples\n", name);
+		return;
+	}
+
+	/* Sort samples */
+	qsort(l, num, sizeof(double), cmp_latency);
+
+	/* Print percentiles in milliseconds */
+	printf("%s latency (ms, %d samples): p50 %.2f  p90 %.2f  "
+	       "p99 %.2f  max %.2f\n", name, num,
+	       1000 * l[num / 2], 1000 * l[num * 9 / 10],
+	       1000 * l[num * 99 / 100], 1000 * l[num - 1]);
+}
+
+/*
+ * Simulate a number of clients playing games on a server.
+ */
+int main(int argc, char *argv[])
+{
+	struct pollfd *fds;
+	int *fd_sim;
+	pid_t *fd_ai;
+	double start, elapsed, cur, wait, cpu_start, cpu_end;
+	int i, n, num_fds, done, timeout;
+
+	/* Assume a few clients */
+	num_sim = 12;
+
+	/* Parse arguments */
+	for (i = 1; i < argc; i++)
+	{
+		/* Check for help */
+		if (!strcmp(argv[i], "-h"))
+		{
+			/* Print usage */
+			printf("Race for the Galaxy server load test\n\n");
+			printf("Arguments:\n");
+			printf("  -s     Server host. Default: localhost\n");
+			printf("  -p     Server port. Default: 16309\n");
+			printf("  -c     Number of simulated clients. Default: 12\n");
+			printf("  -n     Players per game. Default: 3\n");
+			printf("  -e     Expansion level. Default: 0\n");
+			printf("  -g     Games to play per group. Default: 1\n");
+			printf("  -t     Mean think time per answer in milliseconds. Default: 0\n");
+			printf("  -u     User name prefix. Default: \"load\"\n");
+			printf("  -x     Path to ai_client. Default: \"./ai_client\"\n");
+			printf("  -P     Server process ID, to report server CPU use.\n");
+			printf("  -h     Print this usage text and exit.\n");
+			exit(0);
+		}
+
+		/* Check for server host */
+		else if (!strcmp(argv[i], "-s"))
+		{
+			/* Set host */
+			server_host = argv[++i];
+		}
+
+		/* Check for server port */
+		else if (!strcmp(argv[i], "-p"))
+		{
+			/* Set port */
+			server_port = atoi(argv[++i]);
+		}
+
+		/* Check for number of clients */
+		else if (!strcmp(argv[i], "-c"))
+		{
+			/* Set number of clients */
+			num_sim = atoi(argv[++i]);
+		}
+
+		/* Check for players per game */
+		else if (!strcmp(argv[i], "-n"))
+		{
+			/* Set number of players */
+			num_players = atoi(argv[++i]);
+		}
+
+		/* Check for expansion level */
+		else if (!strcmp(argv[i], "-e"))
+		{
+			/* Set expansion level */
+			expansion = atoi(argv[++i]);
+		}
+
+		/* Check for number of games */
+		else if (!strcmp(argv[i], "-g"))
+		{
+			/* Set number of games */
+			num_games = atoi(argv[++i]);
+		}
+
+		/* Check for think time */
+		else if (!strcmp(argv[i], "-t"))
+		{
+			/* Set think time */
+			think_time = atoi(argv[++i]);
+		}
+
+		/* Check for user name prefix */
+		else if (!strcmp(argv[i], "-u"))
+		{
+			/* Set prefix */
+			user_prefix = argv[++i];
+		}
+
+		/* Check for ai_client path */
+		else if (!strcmp(argv[i], "-x"))
+		{
+			/* Set path */
+			ai_path = argv[++i];
+		}
+
+		/* Check for server process */
+		else if (!strcmp(argv[i], "-P"))
+		{
+			/* Set process ID */
+			server_pid = atoi(argv[++i]);
+		}
+	}
+
+	/* Validate players per game */
+	if (num_players < 2) num_players = 2;
+	if (num_players > MAX_PLAYER) num_players = MAX_PLAYER;
+
+	/* Use whole groups of clients only */
+	num_group = num_sim / num_players;
+	num_sim = num_group * num_players;
+
+	/* Check for too few clients */
+	if (!num_group)
+	{
+		/* Error */
+		printf("Need at least %d clients\n", num_players);
+		exit(1);
+	}
+
+	/* Do not die when a connection closes */
+	signal(SIGPIPE, SIG_IGN);
+
+	/* Seed think time generator */
+	srand(time(NULL));
+
+	/* Create clients and groups */
+	sims = (sim_client *)calloc(num_sim, sizeof(sim_client));
+	groups = (sim_group *)calloc(num_group, sizeof(sim_group));
+
+	/* Create poll lists */
+	fds = (struct pollfd *)malloc(sizeof(struct pollfd) * 2 * num_sim);
+	fd_sim = (int *)malloc(sizeof(int) * 2 * num_sim);
+	fd_ai = (pid_t *)malloc(sizeof(pid_t) * 2 * num_sim);
+
+	/* Remember start time */
+	start = now();
+	cpu_start = server_cpu();
+
+	/* Loop over groups */
+	for (i = 0; i < num_group; i++)
+	{
+		/* Set first member */
+		groups[i].first = i * num_players;
+	}
+
+	/* Loop over clients */
+	for (i = 0; i < num_sim; i++)
+	{
+		/* Set group */
+		sims[i].group = i / num_players;
+
+		/* Connect and log in */
+		connect_sim(i);
+	}
+
+	/* Loop until every group is finished */
+	while (1)
+	{
+		/* Get current time */
+		cur = now();
+
+		/* Assume done */
+		done = 1;
+
+		/* Assume no answers waiting */
+		wait = -1;
+
+		/* Clear poll list */
+		num_fds = 0;
+
+		/* Loop over clients */
+		for (i = 0; i < num_sim; i++)
+		{
+			/* Send answers that are ready */
+			release_answers(i, cur);
+
+			/* Check for client not done */
+			if (sims[i].state != LS_DONE) done = 0;
+
+			/* Check for answers still waiting */
+			if (sims[i].pend_len &&
+			    (wait < 0 || sims[i].pend_time - cur < wait))
+			{
+				/* Remember shortest wait */
+				wait = sims[i].pend_time - cur;
+			}
+
+			/* Add server connection */
+			fds[num_fds].fd = sims[i].fd;
+			fds[num_fds].events = POLLIN;
+			fd_sim[num_fds] = i;
+			fd_ai[num_fds++] = 0;
+
+			/* Check for A.I. running */
+			if (sims[i].ai_fd >= 0)
+			{
+				/* Add A.I. connection */
+				fds[num_fds].fd = sims[i].ai_fd;
+				fds[num_fds].events = POLLIN;
+				fd_sim[num_fds] = i;
+				fd_ai[num_fds++] = sims[i].ai_pid;
+			}
+		}
+
+		/* Check for finished */
+		if (done) break;
+
+		/* Compute poll timeout */
+		timeout = wait < 0 ? 1000 : (int)(wait * 1000) + 1;
+
+		/* Wait for data */
+		if (poll(fds, num_fds, timeout) < 0)
+		{
+			/* Check for interruption */
+			if (errno == EINTR) continue;
+
+			/* Error */
+			perror("poll");
+			exit(1);
+		}
+
+		/* Loop over connections */
+		for (i = 0; i < num_fds; i++)
+		{
+			/* Skip idle connections */
+			if (!fds[i].revents) continue;
+
+			/* Get client */
+			n = fd_sim[i];
+
+			/* Check for A.I. connection */
+			if (fd_ai[i])
+			{
+				/* Skip A.I. stopped (or replaced) meanwhile */
+				if (sims[n].ai_fd != fds[i].fd ||
+				    sims[n].ai_pid != fd_ai[i]) continue;
+
+				/* Read answers */
+				if (!read_data(n, fds[i].fd, sims[n].ai_buf,
+				               &sims[n].ai_full, 1))
+				{
+					/* A.I. exited during game */
+					ai_died(n);
+				}
+			}
+
+			/* Read from server */
+			else if (!read_data(n, fds[i].fd, sims[n].buf,
+			                    &sims[n].buf_full, 0))
+			{
+				/* Error */
+				printf("Server closed connection\n");
+				exit(1);
+			}
+		}
+	}
+
+	/* Compute elapsed time */
+	elapsed = now() - start;
+	cpu_end = server_cpu();
+
+	/* Print summary */
+	printf("Clients: %d in %d groups of %d\n", num_sim, num_group,
+	       num_players);
+	printf("Games: %d in %.1f s (%.2f games/min), "
+	       "mean game length %.1f s\n", games_done, elapsed,
+	       60 * games_done / elapsed, game_time / games_done);
+	printf("Messages: %ld received (%.0f/s, %.0f KB/s), "
+	       "%ld sent (%.0f/s)\n", msg_recv, msg_recv / elapsed,
+	       bytes_recv / elapsed / 1024, msg_sent, msg_sent / elapsed);
+
+	/* Print latencies */
+	report_latency("Lobby", LAT_LOBBY);
+	report_latency("Answer", LAT_GAME);
+
+	/* Check for known server CPU use */
+	if (cpu_start >= 0 && cpu_end >= 0)
+	{
+		/* Print server CPU use */
+		printf("Server CPU: %.2f s (%.1f%% of one core), "
+		       "%.1f ms per game\n", cpu_end - cpu_start,
+		       100 * (cpu_end - cpu_start) / elapsed,
+		       1000 * (cpu_end - cpu_start) / games_done);
+	}
+
+	/* Done */
+	return 0;
+}
@@ -39,6 +39,7 @@ static void init_weight(double *wgt)
  */
 void make_learner(net *learn, int input, int hidden, int output)
 {
+	net_acc *a_ptr;
 	int i;
 
 	/* Set number of outputs */
@@ -59,6 +60,41 @@ void make_learner(net *learn, int input, int hidden, int output)
 	/* Create array for previous inputs */
 	learn->prev_input = (double *)malloc(sizeof(double) * (input + 1));
 
+	/* Create lists of active inputs */
+	learn->active_index = (int *)malloc(sizeof(int) * input);
+	learn->prev_active = (int *)malloc(sizeof(int) * input);
+
+	/* Create list of changed inputs */
+	learn->changed_input = (int *)malloc(sizeof(int) * 2 * input);
+
+	/* Create array of rounds in which inputs were set */
+	learn->input_round = (uint32_t *)calloc(sizeof(uint32_t), input);
+
+	/* No active inputs */
+	learn->num_active = learn->num_prev_active = 0;
+	learn->cur_round = 0;
+
+	/* Previous inputs are not known to be sparse */
+	learn->prev_active_valid = 0;
+
+	/* Loop over saved sum stack entries */
+	for (i = 0; i < NET_STACK_MAX; i++)
+	{
+		/* Get stack entry */
+		a_ptr = &learn->acc_stack[i];
+
+		/* Create saved sums and inputs */
+		a_ptr->hidden_sum = (double *)malloc(sizeof(double) * hidden);
+		a_ptr->active_index = (int *)malloc(sizeof(int) * input);
+		a_ptr->active_value = (double *)malloc(sizeof(double) * input);
+
+		/* Entry is unused */
+		a_ptr->valid = 0;
+	}
+
+	/* Stack is empty */
+	learn->acc_depth = 0;
+
 	/* Create hidden sum array */
 	learn->hidden_sum = (double *)malloc(sizeof(double) * hidden);
 
@@ -78,6 +114,13 @@ void make_learner(net *learn, int input, int hidden, int output)
 	learn->input_value[input] = 1.0;
 	learn->hidden_result[hidden] = 1.0;
 
+	/* Create training scratch arrays */
+	learn->hidden_corr = (double *)malloc(sizeof(double) * hidden);
+	learn->weighted_prob = (double *)malloc(sizeof(double) * hidden);
+	learn->output_error = (double *)malloc(sizeof(double) * output);
+	learn->output_deriv = (double *)malloc(sizeof(double) * output);
+	learn->output_corr = (double *)malloc(sizeof(double) * output);
+
 	/* Create rows of hidden weights */
 	learn->hidden_weight = (double **)malloc(sizeof(double *) *
 	                                         (input + 1));
@@ -86,18 +129,32 @@ void make_learner(net *learn, int input, int hidden, int output)
 	learn->hidden_delta = (double **)malloc(sizeof(double *) *
 	                                        (input + 1));
 
-	/* Loop over hidden weight rows */
-	for (i = 0; i < input + 1; i++)
+	/* Create contiguous storage for all hidden weight rows */
+	learn->hidden_weight[0] = (double *)calloc(sizeof(double),
+	                                           (input + 1) * hidden);
+	learn->hidden_delta[0] = (double *)calloc(sizeof(double),
+	                                          (input + 1) * hidden);
+
+	/* Loop over remaining hidden weight rows */
+	for (i = 1; i < input + 1; i++)
 	{
-		/* Create weight row */
-		learn->hidden_weight[i] = (double *)calloc(sizeof(double),
-		                                           hidden);
+		/* Point to weight row */
+		learn->hidden_weight[i] = learn->hidden_weight[0] + i * hidden;
 
-		/* Create weight delta row */
-		learn->hidden_delta[i] = (double *)calloc(sizeof(double),
-		                                          hidden);
+		/* Point to weight delta row */
+		learn->hidden_delta[i] = learn->hidden_delta[0] + i * hidden;
 	}
 
+	/* Create delta shared by every input */
+	learn->default_delta = (double *)calloc(sizeof(double), hidden);
+	learn->default_touched = 0;
+
+	/* Create list of inputs with deltas */
+	learn->touched_input = (int *)malloc(sizeof(int) * (input + 1));
+	learn->input_touched = (char *)calloc(sizeof(char), input + 1);
+	learn->num_touched = 0;
+	learn->all_touched = 0;
+
 	/* Create rows of output weights */
 	learn->output_weight = (double **)malloc(sizeof(double *) *
 	                                         (hidden + 1));
@@ -106,18 +163,25 @@ void make_learner(net *learn, int input, int hidden, int output)
 	learn->output_delta = (double **)malloc(sizeof(double *) *
 	                                        (hidden + 1));
 
-	/* Loop over output weight rows */
-	for (i = 0; i < hidden + 1; i++)
+	/* Create contiguous storage for all output weight rows */
+	learn->output_weight[0] = (double *)calloc(sizeof(double),
+	                                           (hidden + 1) * output);
+	learn->output_delta[0] = (double *)calloc(sizeof(double),
+	                                          (hidden + 1) * output);
+
+	/* Loop over remaining output weight rows */
+	for (i = 1; i < hidden + 1; i++)
 	{
-		/* Create weight row */
-		learn->output_weight[i] = (double *)calloc(sizeof(double),
-		                                           output);
+		/* Point to weight row */
+		learn->output_weight[i] = learn->output_weight[0] + i * output;
 
-		/* Create weight delta row */
-		learn->output_delta[i] = (double *)calloc(sizeof(double),
-		                                          output);
+		/* Point to weight delta row */
+		learn->output_delta[i] = learn->output_delta[0] + i * output;
 	}
 
+	/* Weights are our own */
+	learn->shared_weights = 0;
+
 	/* Clear hidden sums */
 	memset(learn->hidden_sum, 0, sizeof(double) * hidden);
 
@@ -127,13 +191,17 @@ void make_learner(net *learn, int input, int hidden, int output)
 	/* Clear previous inputs */
 	memset(learn->prev_input, 0, sizeof(double) * (input + 1));
 
-	/* Create set of previous inputs */
-	learn->past_input = (double **)malloc(sizeof(double *) * PAST_MAX);
+	/* Create ring buffer of previous input sets (filled in as needed) */
+	learn->past_index = (int **)calloc(sizeof(int *), PAST_MAX);
+	learn->past_value = (double **)calloc(sizeof(double *), PAST_MAX);
+	learn->past_count = (int *)calloc(sizeof(int), PAST_MAX);
+	learn->past_size = (int *)calloc(sizeof(int), PAST_MAX);
 
 	/* Create set of previous input players */
 	learn->past_input_player = (int *)malloc(sizeof(int) * PAST_MAX);
 
 	/* No past inputs available */
+	learn->past_start = 0;
 	learn->num_past = 0;
 
 	/* No training done */
@@ -189,23 +257,51 @@ static double sigmoid(double x)
 	return tanh(x);
 }
 
-#if 0
 /*
- * SIMD type.  Two doubles at once.
+ * SIMD type.  Two doubles at once (rows need not be 16-byte aligned).
  */
-typedef double v2d __attribute__ ((vector_size (16)));
-#endif
+typedef double v2d __attribute__ ((vector_size (16), aligned (8),
+                                   may_alias));
 
 /*
- * Compute a neural net's result.
+ * Add a multiple of one row of values to another.
  */
-void compute_net(net *learn)
+static void add_scaled(double *dest, double *src, double x, int n)
 {
-	int i, j;
-	double sum, adj = 0.0;
-#if 0
-	v2d *weight, *hid_sum;
-#endif
+	v2d scale = { x, x };
+	int i;
+
+	/* Loop over pairs of values */
+	for (i = 0; i + 1 < n; i += 2)
+	{
+		/* Add two scaled values at once */
+		*(v2d *)&dest[i] += *(v2d *)&src[i] * scale;
+	}
+
+	/* Add last value if odd count */
+	if (i < n) dest[i] += src[i] * x;
+}
+
+/*
+ * Update the hidden node sums for a change in one input.
+ */
+static void update_input(net *learn, int i)
+{
+	/* Add weight row, scaled by change in input, to sums */
+	add_scaled(learn->hidden_sum, learn->hidden_weight[i],
+	           learn->input_value[i] - learn->prev_input[i],
+	           learn->num_hidden);
+
+	/* Store input */
+	learn->prev_input[i] = learn->input_value[i];
+}
+
+/*
+ * Update the hidden node sums for every changed input.
+ */
+static void update_hidden(net *learn)
+{
+	int i;
 
 	/* Loop over inputs */
 	for (i = 0; i < learn->num_inputs + 1; i++)
@@ -213,60 +309,19 @@ void compute_net(net *learn)
 		/* Check for difference from previous input */
 		if (learn->input_value[i] != learn->prev_input[i])
 		{
-#if 0
-			for (j = 0; j < learn->num_hidden; j += 2)
-			{
-				weight = &learn->hidden_weight[i][j];
-				hid_sum = &learn->hidden_sum[j];
-
-				*hid_sum += *weight * (learn->input_value[i] -
-						       learn->prev_input[i]);
-			}
-#else
-			/* Check for increase by one */
-			if (learn->input_value[i] - learn->prev_input[i] == 2)
-			{
-				/* Add weight value to sum */
-				for (j = 0; j < learn->num_hidden; j++)
-				{
-					/* Adjust sum */
-					learn->hidden_sum[j] +=
-					             2 * learn->hidden_weight[i][j];
-				}
-			}
-
-			/* Check for decrease by one */
-			else if (learn->input_value[i] -
-			         learn->prev_input[i] == -2)
-			{
-				/* Subtract weight value from sum */
-				for (j = 0; j < learn->num_hidden; j++)
-				{
-					/* Adjust sum */
-					learn->hidden_sum[j] -=
-					             2 * learn->hidden_weight[i][j];
-				}
-			}
-
-			/* Input changed by fractional amount */
-			else
-			{
-				/* Loop over hidden weights */
-				for (j = 0; j < learn->num_hidden; j++)
-				{
-					/* Adjust sum */
-					learn->hidden_sum[j] +=
-					           learn->hidden_weight[i][j] *
-					                (learn->input_value[i] -
-				                         learn->prev_input[i]);
-				}
-			}
-#endif
-
-			/* Store input */
-			learn->prev_input[i] = learn->input_value[i];
+			/* Update sums */
+			update_input(learn, i);
 		}
 	}
+}
+
+/*
+ * Compute the network outputs from the hidden node sums.
+ */
+static void compute_output(net *learn)
+{
+	int i, j;
+	double sum, adj = 0.0;
 
 	/* Normalize hidden node results */
 	for (i = 0; i < learn->num_hidden; i++)
@@ -315,74 +370,707 @@ void compute_net(net *learn)
 }
 
 /*
- * Store the current inputs into the past set array.
+ * Compute a neural net's result.
  */
-void store_net(net *learn, int who)
+void compute_net(net *learn)
 {
-	int i;
+	/* Update hidden sums from all inputs */
+	update_hidden(learn);
 
-	/* Check for too many past inputs already */
-	if (learn->num_past == PAST_MAX)
+	/* Previous inputs may now have any values */
+	learn->prev_active_valid = 0;
+
+	/* Compute outputs */
+	compute_output(learn);
+}
+
+/*
+ * Start a new set of sparse inputs.
+ *
+ * Every input not set with set_input() before the next call to
+ * compute_net_sparse() has the value DEFAULT_INPUT.
+ */
+void clear_inputs(net *learn)
+{
+	/* Advance round */
+	learn->cur_round++;
+
+	/* Check for wrapped counter */
+	if (!learn->cur_round)
+	{
+		/* Forget rounds of old inputs */
+		memset(learn->input_round, 0,
+		       sizeof(uint32_t) * learn->num_inputs);
+
+		/* Start over after cleared rounds */
+		learn->cur_round = 1;
+	}
+
+	/* No inputs active */
+	learn->num_active = 0;
+}
+
+/*
+ * Set the value of one input in the current set of sparse inputs.
+ */
+void set_input(net *learn, int i, double value)
+{
+	/* Inputs not already set have the default value */
+	if (value == DEFAULT_INPUT && learn->input_round[i] != learn->cur_round)
+		return;
+
+	/* Store value */
+	learn->input_value[i] = value;
+
+	/* Check for input not yet set this round */
+	if (learn->input_round[i] != learn->cur_round)
+	{
+		/* Mark input as set */
+		learn->input_round[i] = learn->cur_round;
+
+		/* Add to active list */
+		learn->active_index[learn->num_active++] = i;
+	}
+}
+
+/*
+ * Compare two input indices.
+ */
+static int cmp_input(const void *a, const void *b)
+{
+	/* Compare */
+	return *(int *)a - *(int *)b;
+}
+
+/*
+ * Compute a neural net's result from the current set of sparse inputs.
+ *
+ * Only the hidden weight rows of inputs that changed since the last
+ * sparse computation are visited, so the cost depends on the number of
+ * active inputs rather than the size of the network.
+ */
+void compute_net_sparse(net *learn)
+{
+	int i, k, num_changed = 0;
+	int *tmp;
+
+	/* Check for unknown previous inputs */
+	if (!learn->prev_active_valid)
+	{
+		/* Loop over inputs */
+		for (i = 0; i < learn->num_inputs; i++)
+		{
+			/* Reset inputs not set this round */
+			if (learn->input_round[i] != learn->cur_round)
+				learn->input_value[i] = DEFAULT_INPUT;
+		}
+
+		/* Update hidden sums from all inputs */
+		update_hidden(learn);
+	}
+	else
+	{
+		/* Loop over inputs set this round */
+		for (k = 0; k < learn->num_active; k++)
+		{
+			/* Get input index */
+			i = learn->active_index[k];
+
+			/* Check for changed input */
+			if (learn->input_value[i] != learn->prev_input[i])
+				learn->changed_input[num_changed++] = i;
+		}
+
+		/* Loop over inputs set last time */
+		for (k = 0; k < learn->num_prev_active; k++)
+		{
+			/* Get input index */
+			i = learn->prev_active[k];
+
+			/* Skip inputs set again this round */
+			if (learn->input_round[i] == learn->cur_round) continue;
+
+			/* Reset input */
+			learn->input_value[i] = DEFAULT_INPUT;
+
+			/* Check for changed input */
+			if (learn->prev_input[i] != DEFAULT_INPUT)
+				learn->changed_input[num_changed++] = i;
+		}
+
+		/* Sort changes, so sums are added in the same order as above */
+		qsort(learn->changed_input, num_changed, sizeof(int),
+		      cmp_input);
+
+		/* Loop over changed inputs */
+		for (k = 0; k < num_changed; k++)
+		{
+			/* Update sums */
+			update_input(learn, learn->changed_input[k]);
+		}
+	}
+
+	/* Current active inputs become previous ones */
+	tmp = learn->prev_active;
+	learn->prev_active = learn->active_index;
+	learn->active_index = tmp;
+	learn->num_prev_active = learn->num_active;
+
+	/* Previous inputs are known */
+	learn->prev_active_valid = 1;
+
+	/* Compute outputs */
+	compute_output(learn);
+}
+
+/*
+ * Save the current hidden node sums on the stack.
+ *
+ * Later sparse computations start from the saved sums, and pop_net()
+ * returns to them, so that sibling states in a search are each computed
+ * as a difference from their common parent rather than from one another.
+ */
+void push_net(net *learn)
+{
+	net_acc *a_ptr;
+	int i, k;
+
+	/* Check for full stack */
+	if (learn->acc_depth == NET_STACK_MAX) return;
+
+	/* Get next stack entry */
+	a_ptr = &learn->acc_stack[learn->acc_depth++];
+
+	/* Remember whether current sums come from known sparse inputs */
+	a_ptr->valid = learn->prev_active_valid;
+
+	/* Nothing more to save if not */
+	if (!a_ptr->valid) return;
+
+	/* Save hidden sums */
+	memcpy(a_ptr->hidden_sum, learn->hidden_sum,
+	       sizeof(double) * learn->num_hidden);
+
+	/* Loop over active inputs */
+	for (k = 0; k < learn->num_prev_active; k++)
 	{
-		/* Destroy oldest set */
-		free(learn->past_input[0]);
+		/* Get input index */
+		i = learn->prev_active[k];
+
+		/* Save input and value */
+		a_ptr->active_index[k] = i;
+		a_ptr->active_value[k] = learn->prev_input[i];
+	}
 
-		/* Move all inputs up one spot */
-		for (i = 0; i < PAST_MAX - 1; i++)
+	/* Save number of active inputs */
+	a_ptr->num_active = learn->num_prev_active;
+}
+
+/*
+ * Return to the hidden node sums saved by the matching push_net().
+ *
+ * This must not be called between set_input() and compute_net_sparse().
+ */
+void pop_net(net *learn)
+{
+	net_acc *a_ptr;
+	int i, k;
+
+	/* Check for empty stack */
+	if (!learn->acc_depth) return;
+
+	/* Get top stack entry */
+	a_ptr = &learn->acc_stack[--learn->acc_depth];
+
+	/* Keep current sums if saved ones are unusable */
+	if (!a_ptr->valid) return;
+
+	/* Check for known sparse inputs */
+	if (learn->prev_active_valid)
+	{
+		/* Loop over active inputs */
+		for (k = 0; k < learn->num_prev_active; k++)
 		{
-			/* Move one set of inputs */
-			learn->past_input[i] = learn->past_input[i + 1];
+			/* Get input index */
+			i = learn->prev_active[k];
 
-			/* Move one player index */
-			learn->past_input_player[i] =
-			                  learn->past_input_player[i + 1];
+			/* Reset input */
+			learn->input_value[i] = learn->prev_input[i] =
+			                                        DEFAULT_INPUT;
 		}
+	}
+	else
+	{
+		/* Loop over all inputs */
+		for (i = 0; i < learn->num_inputs; i++)
+		{
+			/* Reset input */
+			learn->input_value[i] = learn->prev_input[i] =
+			                                        DEFAULT_INPUT;
+		}
+
+		/* Bias input is always one */
+		learn->input_value[i] = learn->prev_input[i] = 1.0;
+	}
+
+	/* Restore hidden sums */
+	memcpy(learn->hidden_sum, a_ptr->hidden_sum,
+	       sizeof(double) * learn->num_hidden);
+
+	/* Loop over saved inputs */
+	for (k = 0; k < a_ptr->num_active; k++)
+	{
+		/* Get input index */
+		i = a_ptr->active_index[k];
+
+		/* Restore input */
+		learn->input_value[i] = learn->prev_input[i] =
+		                                      a_ptr->active_value[k];
+
+		/* Restore active list */
+		learn->prev_active[k] = i;
+	}
+
+	/* Restore number of active inputs */
+	learn->num_prev_active = a_ptr->num_active;
+
+	/* Sums come from known sparse inputs */
+	learn->prev_active_valid = 1;
+}
+
+/*
+ * Push or pop saved hidden node sums until the stack has the given depth.
+ *
+ * Callers pass the depth of the simulated game being evaluated, so each
+ * evaluation is computed relative to the last one at the same depth.
+ */
+void set_net_depth(net *learn, int depth)
+{
+	/* Limit depth to size of stack */
+	if (depth > NET_STACK_MAX) depth = NET_STACK_MAX;
+
+	/* Return from deeper states */
+	while (learn->acc_depth > depth) pop_net(learn);
+
+	/* Save state of shallower levels */
+	while (learn->acc_depth < depth) push_net(learn);
+}
+
+/*
+ * Store the current inputs into the past set ring buffer.
+ *
+ * Only inputs without the default value are kept.  Each slot's lists
+ * are reused, and only grow when a set has more inputs than any before.
+ */
+void store_net(net *learn, int who)
+{
+	int i, k, n = 0, slot, max;
+
+	/* Check for too many past inputs already */
+	if (learn->num_past == PAST_MAX)
+	{
+		/* Forget oldest set */
+		learn->past_start = (learn->past_start + 1) % PAST_MAX;
 
 		/* We now have one fewer set */
 		learn->num_past--;
 	}
 
-	/* Make space for new inputs */
-	learn->past_input[learn->num_past] = malloc(sizeof(double) *
-	                                            (learn->num_inputs + 1));
+	/* Get slot for new inputs */
+	slot = (learn->past_start + learn->num_past) % PAST_MAX;
+
+	/* Find most inputs that may need storing */
+	max = learn->prev_active_valid ? learn->num_prev_active :
+	                                 learn->num_inputs;
+
+	/* Check for insufficient room in slot */
+	if (learn->past_size[slot] < max)
+	{
+		/* Make room */
+		learn->past_size[slot] = max;
+
+		/* Grow lists */
+		learn->past_index[slot] = (int *)
+		      realloc(learn->past_index[slot], sizeof(int) * max);
+		learn->past_value[slot] = (double *)
+		      realloc(learn->past_value[slot], sizeof(double) * max);
+	}
+
+	/* Check for known list of active inputs */
+	if (learn->prev_active_valid)
+	{
+		/* Loop over active inputs */
+		for (k = 0; k < learn->num_prev_active; k++)
+		{
+			/* Get input index */
+			i = learn->prev_active[k];
+
+			/* Skip inputs set to default */
+			if (learn->input_value[i] == DEFAULT_INPUT) continue;
+
+			/* Copy input */
+			learn->past_index[slot][n] = i;
+			learn->past_value[slot][n++] = learn->input_value[i];
+		}
+	}
+	else
+	{
+		/* Loop over inputs */
+		for (i = 0; i < learn->num_inputs; i++)
+		{
+			/* Skip inputs with default value */
+			if (learn->input_value[i] == DEFAULT_INPUT) continue;
+
+			/* Copy input */
+			learn->past_index[slot][n] = i;
+			learn->past_value[slot][n++] = learn->input_value[i];
+		}
+	}
 
-	/* Copy inputs */
-	memcpy(learn->past_input[learn->num_past], learn->input_value,
-	       sizeof(double) * (learn->num_inputs + 1));
+	/* Save number of inputs */
+	learn->past_count[slot] = n;
 
 	/* Copy player index */
-	learn->past_input_player[learn->num_past] = who;
+	learn->past_input_player[slot] = who;
 
 	/* One additional set */
 	learn->num_past++;
 }
 
 /*
- * Clean up past stored inputs.
+ * Return the player who created a past input set (0 is oldest).
  */
-void clear_store(net *learn)
+int past_player(net *learn, int k)
+{
+	/* Look up player in ring buffer */
+	return learn->past_input_player[(learn->past_start + k) % PAST_MAX];
+}
+
+/*
+ * Load a past input set (0 is oldest) as the current sparse inputs.
+ *
+ * Call compute_net_sparse() afterwards to compute the network's result.
+ */
+void load_past(net *learn, int k)
+{
+	int i, slot;
+
+	/* Get slot in ring buffer */
+	slot = (learn->past_start + k) % PAST_MAX;
+
+	/* Start new set of inputs */
+	clear_inputs(learn);
+
+	/* Loop over stored inputs */
+	for (i = 0; i < learn->past_count[slot]; i++)
+	{
+		/* Set input */
+		set_input(learn, learn->past_index[slot][i],
+		          learn->past_value[slot][i]);
+	}
+}
+
+/*
+ * Append a player's past input sets to a training dataset, each with the
+ * given desired outputs.
+ *
+ * Each record holds the number of outputs and of active inputs (as
+ * 32-bit integers), the desired outputs (as floats), then the active
+ * input indices (16-bit) and values (floats).  Inputs not listed have
+ * the default value.
+ */
+void write_samples(net *learn, FILE *fff, int who, double *desired)
 {
+	unsigned short index;
+	float value;
+	int header[2];
+	int i, k, slot;
+
+	/* Loop over past input sets */
+	for (k = 0; k < learn->num_past; k++)
+	{
+		/* Skip input sets that do not belong to player */
+		if (past_player(learn, k) != who) continue;
+
+		/* Get slot in ring buffer */
+		slot = (learn->past_start + k) % PAST_MAX;
+
+		/* Create record header */
+		header[0] = learn->num_output;
+		header[1] = learn->past_count[slot];
+
+		/* Write record header */
+		fwrite(header, sizeof(int), 2, fff);
+
+		/* Loop over outputs */
+		for (i = 0; i < learn->num_output; i++)
+		{
+			/* Write desired output */
+			value = desired[i];
+			fwrite(&value, sizeof(float), 1, fff);
+		}
+
+		/* Loop over inputs */
+		for (i = 0; i < header[1]; i++)
+		{
+			/* Write input index */
+			index = learn->past_index[slot][i];
+			fwrite(&index, sizeof(unsigned short), 1, fff);
+		}
+
+		/* Loop over inputs */
+		for (i = 0; i < header[1]; i++)
+		{
+			/* Write input value */
+			value = learn->past_value[slot][i];
+			fwrite(&value, sizeof(float), 1, fff);
+		}
+	}
+}
+
+/*
+ * Free the arrays of a training position.
+ */
+void free_sample(net_sample *s_ptr)
+{
+	/* Free arrays */
+	free(s_ptr->desired);
+	free(s_ptr->index);
+	free(s_ptr->value);
+}
+
+/*
+ * Read one training position from a dataset written by write_samples().
+ *
+ * Return 1 on success, 0 at end of file, and -1 if the record does not
+ * fit the network.
+ */
+int read_sample(net *learn, FILE *fff, net_sample *s_ptr)
+{
+	float want;
+	int header[2];
 	int i;
 
-	/* Loop over previous stored inputs */
-	for (i = 0; i < learn->num_past; i++)
+	/* Read record header */
+	if (fread(header, sizeof(int), 2, fff) != 2) return 0;
+
+	/* Check for mismatch */
+	if (header[0] != learn->num_output || header[1] < 0 ||
+	    header[1] > learn->num_inputs) return -1;
+
+	/* Create arrays */
+	s_ptr->desired = (double *)malloc(sizeof(double) * header[0]);
+	s_ptr->index = (unsigned short *)malloc(sizeof(unsigned short) *
+	                                        header[1]);
+	s_ptr->value = (float *)malloc(sizeof(float) * header[1]);
+	s_ptr->num_active = header[1];
+
+	/* Loop over outputs */
+	for (i = 0; i < header[0]; i++)
+	{
+		/* Read desired output */
+		if (fread(&want, sizeof(float), 1, fff) != 1)
+		{
+			/* Failure */
+			free_sample(s_ptr);
+			return -1;
+		}
+
+		/* Convert to double */
+		s_ptr->desired[i] = want;
+	}
+
+	/* Read active inputs */
+	if (fread(s_ptr->index, sizeof(unsigned short), header[1], fff) !=
+	    header[1] ||
+	    fread(s_ptr->value, sizeof(float), header[1], fff) != header[1])
 	{
-		/* Free inputs */
-		free(learn->past_input[i]);
+		/* Failure */
+		free_sample(s_ptr);
+		return -1;
 	}
 
+	/* Loop over inputs */
+	for (i = 0; i < header[1]; i++)
+	{
+		/* Check for bad index */
+		if (s_ptr->index[i] >= learn->num_inputs)
+		{
+			/* Failure */
+			free_sample(s_ptr);
+			return -1;
+		}
+	}
+
+	/* Success */
+	return 1;
+}
+
+/*
+ * Train a network on one recorded position.
+ *
+ * Corrections are accumulated until apply_training() is called.
+ */
+void train_sample(net *learn, net_sample *s_ptr)
+{
+	int i;
+
+	/* Start new set of inputs */
+	clear_inputs(learn);
+
+	/* Loop over recorded inputs */
+	for (i = 0; i < s_ptr->num_active; i++)
+	{
+		/* Set input */
+		set_input(learn, s_ptr->index[i], s_ptr->value[i]);
+	}
+
+	/* Compute network */
+	compute_net_sparse(learn);
+
+	/* Train */
+	train_net(learn, 1.0, s_ptr->desired);
+}
+
+/*
+ * Clean up past stored inputs.
+ *
+ * The ring buffer's lists are kept for reuse.
+ */
+void clear_store(net *learn)
+{
 	/* Clear number of past inputs */
+	learn->past_start = 0;
 	learn->num_past = 0;
 }
 
+/*
+ * Clear the stored hidden node sums and previous inputs.
+ *
+ * The next computation then starts from scratch.
+ */
+static void reset_sums(net *learn)
+{
+	/* Clear stored sums */
+	memset(learn->hidden_sum, 0, sizeof(double) * learn->num_hidden);
+
+	/* Clear previous inputs */
+	memset(learn->prev_input, 0, sizeof(double) * (learn->num_inputs + 1));
+
+	/* Previous inputs are no longer sparse */
+	learn->prev_active_valid = 0;
+}
+
+/*
+ * Forget the stored hidden node sums, because the weights have changed.
+ */
+void clear_sums(net *learn)
+{
+	int i;
+
+	/* Clear stored sums */
+	reset_sums(learn);
+
+	/* Loop over saved sum stack entries */
+	for (i = 0; i < NET_STACK_MAX; i++)
+	{
+		/* Saved sums used old weights */
+		learn->acc_stack[i].valid = 0;
+	}
+}
+
+/*
+ * Note that an input's hidden weight deltas may no longer be zero.
+ */
+static void touch_input(net *learn, int i)
+{
+	/* Check for input already listed */
+	if (learn->input_touched[i]) return;
+
+	/* Add to list */
+	learn->input_touched[i] = 1;
+	learn->touched_input[learn->num_touched++] = i;
+}
+
+/*
+ * Forget which inputs have hidden weight deltas.
+ */
+static void clear_touched(net *learn)
+{
+	int k;
+
+	/* Loop over inputs with deltas */
+	for (k = 0; k < learn->num_touched; k++)
+	{
+		/* Input no longer has deltas */
+		learn->input_touched[learn->touched_input[k]] = 0;
+	}
+
+	/* No rows have deltas */
+	learn->num_touched = 0;
+	learn->all_touched = 0;
+}
+
+/*
+ * Add one network's hidden weight deltas to a set of rows, and clear
+ * them.
+ *
+ * Only rows with deltas are visited, unless any row may have them.
+ */
+static void move_deltas(net *learn, double **dest)
+{
+	int i, k, n;
+
+	/* Check for deltas anywhere */
+	if (learn->all_touched)
+	{
+		/* Count hidden weights */
+		n = (learn->num_inputs + 1) * learn->num_hidden;
+
+		/* Add all deltas */
+		add_scaled(dest[0], learn->hidden_delta[0], 1.0, n);
+
+		/* Clear deltas */
+		memset(learn->hidden_delta[0], 0, sizeof(double) * n);
+	}
+	else
+	{
+		/* Loop over inputs with deltas */
+		for (k = 0; k < learn->num_touched; k++)
+		{
+			/* Get input index */
+			i = learn->touched_input[k];
+
+			/* Add deltas */
+			add_scaled(dest[i], learn->hidden_delta[i], 1.0,
+			           learn->num_hidden);
+
+			/* Clear deltas */
+			memset(learn->hidden_delta[i], 0,
+			       sizeof(double) * learn->num_hidden);
+		}
+	}
+
+	/* No rows have deltas */
+	clear_touched(learn);
+}
+
 /*
  * Train a network so that the current results are more like the desired.
+ *
+ * No memory is allocated here; scratch arrays are created with the
+ * network.
+ *
+ * After a sparse computation only the deltas of the active inputs are
+ * visited.  Every input left at its default value gets the same
+ * correction, which is kept once in the default delta until the deltas
+ * are applied.
  */
 void train_net(net *learn, double lambda, double *desired)
 {
 	int i, j, k;
-	double error, corr, deriv, hderiv;
-	double *hidden_corr;
+	double *prob = learn->win_prob, *weight, *delta;
+	double error, hderiv, herror, sum, x;
 
 	/* Count error events */
 	learn->num_error += lambda;
@@ -391,90 +1079,141 @@ void train_net(net *learn, double lambda, double *desired)
 	for (i = 0; i < learn->num_output; i++)
 	{
 		/* Compute error */
-		error = lambda * (learn->win_prob[i] - desired[i]);
+		error = lambda * (prob[i] - desired[i]);
 
 		/* Accumulate squared error */
 		learn->error += error * error;
 
 		/* Output portion of partial derivatives */
-		deriv = learn->win_prob[i] * (1.0 - learn->win_prob[i]);
+		learn->output_deriv[i] = prob[i] * (1.0 - prob[i]);
 
-		/* Loop over node's weights */
-		for (j = 0; j < learn->num_hidden; j++)
-		{
-			/* Compute correction */
-			corr = -error * learn->hidden_result[j] * deriv;
+		/* Remember error */
+		learn->output_error[i] = error;
 
-			/* Compute hidden node's effect on output */
-			hderiv = deriv * learn->output_weight[j][i];
+		/* Compute correction factor for weights into this node */
+		learn->output_corr[i] = learn->alpha * -error *
+		                        learn->output_deriv[i];
+	}
 
-			/* Loop over other output nodes */
-			for (k = 0; k < learn->num_output; k++)
-			{
-				/* Skip this output node */
-				if (i == k) continue;
-
-				/* Subtract this node's factor */
-				hderiv -= learn->output_weight[j][k] *
-				          learn->net_result[i] *
-				          learn->net_result[k] /
-				          (learn->prob_sum * learn->prob_sum);
-			}
+	/* Loop over hidden nodes */
+	for (j = 0; j < learn->num_hidden; j++)
+	{
+		/* Get output weights of hidden node */
+		weight = learn->output_weight[j];
+
+		/* Start sum at zero */
+		sum = 0.0;
+
+		/* Weight outputs by probability */
+		for (i = 0; i < learn->num_output; i++) sum += weight[i] * prob[i];
+
+		/* Save weighted sum */
+		learn->weighted_prob[j] = sum;
+	}
+
+	/* Loop over hidden nodes */
+	for (j = 0; j < learn->num_hidden; j++)
+	{
+		/* Get output weights and deltas of hidden node */
+		weight = learn->output_weight[j];
+		delta = learn->output_delta[j];
 
-			/* Compute hidden node's error */
-			learn->hidden_error[j] += error * hderiv;
+		/* Clear error sum */
+		herror = 0.0;
 
-			/* Apply correction */
-			learn->output_delta[j][i] += learn->alpha * corr;
+		/* Loop over output nodes */
+		for (i = 0; i < learn->num_output; i++)
+		{
+			/*
+			 * Compute hidden node's effect on output.
+			 *
+			 * The softmax cross terms from every other output
+			 * are the probability-weighted sum of this node's
+			 * weights, less this output's own term.
+			 */
+			hderiv = learn->output_deriv[i] * weight[i] -
+			         prob[i] * (learn->weighted_prob[j] -
+			                    weight[i] * prob[i]);
+
+			/* Accumulate hidden node's error */
+			herror += learn->output_error[i] * hderiv;
 		}
 
-		/* Compute bias weight's correction */
-		learn->output_delta[j][i] += learn->alpha * -error * deriv;
+		/* Compute hidden node's error */
+		learn->hidden_error[j] += herror;
+
+		/* Apply corrections */
+		add_scaled(delta, learn->output_corr, learn->hidden_result[j],
+		           learn->num_output);
 	}
 
-	/* Create array of hidden weight correction factors */
-	hidden_corr = (double *)malloc(sizeof(double) * learn->num_hidden);
+	/* Apply bias weight corrections */
+	add_scaled(learn->output_delta[j], learn->output_corr, 1.0,
+	           learn->num_output);
 
 	/* Loop over hidden nodes */
 	for (i = 0; i < learn->num_hidden; i++)
 	{
 		/* Output portion of partial derivatives */
-		deriv = 1 - (learn->hidden_result[i] * learn->hidden_result[i]);
+		hderiv = 1 - (learn->hidden_result[i] * learn->hidden_result[i]);
 
 		/* Calculate correction factor */
-		hidden_corr[i] = deriv * -learn->hidden_error[i] * learn->alpha;
+		learn->hidden_corr[i] = hderiv * -learn->hidden_error[i] *
+		                        learn->alpha;
 	}
 
-	/* Loop over inputs */
-	for (i = 0; i < learn->num_inputs + 1; i++)
+	/* Check for known list of active inputs */
+	if (learn->prev_active_valid)
 	{
-		/* Skip zero inputs */
-		if (!learn->input_value[i]) continue;
+		/* Inputs left at the default value share one correction */
+		add_scaled(learn->default_delta, learn->hidden_corr,
+		           DEFAULT_INPUT, learn->num_hidden);
+		learn->default_touched = 1;
 
-		/* Loop over hidden nodes */
-		for (j = 0; j < learn->num_hidden; j++)
+		/* Loop over active inputs */
+		for (k = 0; k < learn->num_prev_active; k++)
 		{
-			/* Adjust weight */
-			learn->hidden_delta[i][j] += hidden_corr[j] *
-			                                  learn->input_value[i];
-		}
-	}
+			/* Get input index */
+			i = learn->prev_active[k];
 
-	/* Destroy hidden correction factor array */
-	free(hidden_corr);
+			/* Get difference from default value */
+			x = learn->input_value[i] - DEFAULT_INPUT;
 
-	/* Loop over hidden nodes */
-	for (i = 0; i < learn->num_hidden; i++)
+			/* Skip inputs with default value */
+			if (!x) continue;
+
+			/* Adjust weights beyond shared correction */
+			touch_input(learn, i);
+			add_scaled(learn->hidden_delta[i], learn->hidden_corr,
+			           x, learn->num_hidden);
+		}
+
+		/* Adjust bias weights */
+		touch_input(learn, learn->num_inputs);
+		add_scaled(learn->hidden_delta[learn->num_inputs],
+		           learn->hidden_corr,
+		           learn->input_value[learn->num_inputs],
+		           learn->num_hidden);
+	}
+	else
 	{
-		/* Clear node's error */
-		learn->hidden_error[i] = 0;
+		/* Loop over inputs */
+		for (i = 0; i < learn->num_inputs + 1; i++)
+		{
+			/* Skip zero inputs */
+			if (!learn->input_value[i]) continue;
 
-		/* Clear node's stored sum */
-		learn->hidden_sum[i] = 0;
+			/* Adjust weights */
+			add_scaled(learn->hidden_delta[i], learn->hidden_corr,
+			           learn->input_value[i], learn->num_hidden);
+		}
+
+		/* Any delta may be set */
+		learn->all_touched = 1;
 	}
 
-	/* Clear previous inputs */
-	memset(learn->prev_input, 0, sizeof(double) * (learn->num_inputs + 1));
+	/* Clear hidden node errors */
+	memset(learn->hidden_error, 0, sizeof(double) * learn->num_hidden);
 
 #ifdef NOISY
 	compute_net();
@@ -490,35 +1229,176 @@ void train_net(net *learn, double lambda, double *desired)
  */
 void apply_training(net *learn)
 {
-	int i, j;
+	int i, n;
 
-	/* Loop over hidden nodes */
-	for (i = 0; i < learn->num_hidden + 1; i++)
+	/* Count output weights */
+	n = (learn->num_hidden + 1) * learn->num_output;
+
+	/* Apply training to all output weights */
+	add_scaled(learn->output_weight[0], learn->output_delta[0], 1.0, n);
+
+	/* Clear deltas */
+	memset(learn->output_delta[0], 0, sizeof(double) * n);
+
+	/* Apply training to hidden weights with deltas */
+	move_deltas(learn, learn->hidden_weight);
+
+	/* Check for default delta */
+	if (learn->default_touched)
 	{
-		/* Loop over output nodes */
-		for (j = 0; j < learn->num_output; j++)
+		/* Loop over inputs */
+		for (i = 0; i < learn->num_inputs; i++)
 		{
-			/* Apply training */
-			learn->output_weight[i][j] += learn->output_delta[i][j];
-
-			/* Clear delta */
-			learn->output_delta[i][j] = 0;
+			/* Apply default delta */
+			add_scaled(learn->hidden_weight[i],
+			           learn->default_delta, 1.0,
+			           learn->num_hidden);
 		}
+
+		/* Clear default delta */
+		memset(learn->default_delta, 0,
+		       sizeof(double) * learn->num_hidden);
+		learn->default_touched = 0;
 	}
 
-	/* Loop over input values */
-	for (i = 0; i < learn->num_inputs + 1; i++)
+	/* Stored sums used old weights */
+	clear_sums(learn);
+}
+
+/*
+ * Copy the weights of one network to another of the same size.
+ */
+void copy_weights(net *dest, net *src)
+{
+	/* Copy hidden weights */
+	memcpy(dest->hidden_weight[0], src->hidden_weight[0],
+	       sizeof(double) * (src->num_inputs + 1) * src->num_hidden);
+
+	/* Copy output weights */
+	memcpy(dest->output_weight[0], src->output_weight[0],
+	       sizeof(double) * (src->num_hidden + 1) * src->num_output);
+
+	/* Stored sums used old weights */
+	clear_sums(dest);
+}
+
+/*
+ * Add the accumulated training information of one network to another of
+ * the same size, and clear it from the first.
+ *
+ * Only the hidden weight rows the first network trained are added.  A
+ * network training shared weights has already applied its other deltas,
+ * so only its default delta and error counters are added.
+ */
+void add_deltas(net *dest, net *src)
+{
+	int k, n;
+
+	/* Check for own weights */
+	if (!src->shared_weights)
 	{
-		/* Loop over hidden nodes */
-		for (j = 0; j < learn->num_hidden; j++)
-		{
-			/* Apply training */
-			learn->hidden_weight[i][j] += learn->hidden_delta[i][j];
+		/* Count output weights */
+		n = (src->num_hidden + 1) * src->num_output;
 
-			/* Clear delta */
-			learn->hidden_delta[i][j] = 0;
+		/* Add output weight deltas */
+		add_scaled(dest->output_delta[0], src->output_delta[0], 1.0,
+		           n);
+
+		/* Clear source deltas */
+		memset(src->output_delta[0], 0, sizeof(double) * n);
+
+		/* Check for deltas anywhere */
+		if (src->all_touched)
+		{
+			/* Destination may have deltas anywhere */
+			dest->all_touched = 1;
+		}
+		else
+		{
+			/* Loop over inputs with deltas */
+			for (k = 0; k < src->num_touched; k++)
+			{
+				/* Input has deltas in destination */
+				touch_input(dest, src->touched_input[k]);
+			}
 		}
+
+		/* Add hidden weight deltas */
+		move_deltas(src, dest->hidden_delta);
+	}
+	else
+	{
+		/* Deltas were applied as they were made */
+		clear_touched(src);
+	}
+
+	/* Check for default delta */
+	if (src->default_touched)
+	{
+		/* Add default delta */
+		add_scaled(dest->default_delta, src->default_delta, 1.0,
+		           src->num_hidden);
+		dest->default_touched = 1;
+
+		/* Clear source delta */
+		memset(src->default_delta, 0, sizeof(double) * src->num_hidden);
+		src->default_touched = 0;
+	}
+
+	/* Add error counters */
+	dest->error += src->error;
+	dest->num_error += src->num_error;
+
+	/* Clear source error counters */
+	src->error = src->num_error = 0;
+}
+
+/*
+ * Make a network train directly on the weights of another of the same
+ * size.
+ *
+ * The network's delta rows become the other network's weight rows, so
+ * corrections from train_net() take effect at once, without locking.
+ * Several threads may train such networks on one set of weights at the
+ * same time ("Hogwild" training).  Do not call apply_training() on a
+ * network made this way; collect its default delta into the other
+ * network with add_deltas() instead.
+ */
+void share_weights(net *dest, net *src)
+{
+	int i;
+
+	/* Free our own weights, unless already shared */
+	if (!dest->shared_weights)
+	{
+		/* Free storage of weights and deltas */
+		free(dest->hidden_weight[0]);
+		free(dest->hidden_delta[0]);
+		free(dest->output_weight[0]);
+		free(dest->output_delta[0]);
+	}
+
+	/* Loop over hidden weight rows */
+	for (i = 0; i < src->num_inputs + 1; i++)
+	{
+		/* Use other network's row for weights and deltas */
+		dest->hidden_weight[i] = src->hidden_weight[i];
+		dest->hidden_delta[i] = src->hidden_weight[i];
 	}
+
+	/* Loop over output weight rows */
+	for (i = 0; i < src->num_hidden + 1; i++)
+	{
+		/* Use other network's row for weights and deltas */
+		dest->output_weight[i] = src->output_weight[i];
+		dest->output_delta[i] = src->output_weight[i];
+	}
+
+	/* Weights are shared */
+	dest->shared_weights = 1;
+
+	/* Stored sums used old weights */
+	clear_sums(dest);
 }
 
 /*
@@ -531,41 +1411,70 @@ void free_net(net *learn)
 	/* Free simple arrays */
 	free(learn->input_value);
 	free(learn->prev_input);
+	free(learn->active_index);
+	free(learn->prev_active);
+	free(learn->changed_input);
+	free(learn->input_round);
+
+	/* Free saved sum stack */
+	for (i = 0; i < NET_STACK_MAX; i++)
+	{
+		/* Free entry */
+		free(learn->acc_stack[i].hidden_sum);
+		free(learn->acc_stack[i].active_index);
+		free(learn->acc_stack[i].active_value);
+	}
 	free(learn->hidden_sum);
 	free(learn->hidden_result);
 	free(learn->hidden_error);
 	free(learn->net_result);
 	free(learn->win_prob);
 
-	/* Free rows of hidden weights */
-	for (i = 0; i < learn->num_inputs + 1; i++)
+	/* Free training scratch arrays */
+	free(learn->hidden_corr);
+	free(learn->weighted_prob);
+	free(learn->output_error);
+	free(learn->output_deriv);
+	free(learn->output_corr);
+
+	/* Check for own weights */
+	if (!learn->shared_weights)
 	{
-		/* Free weight row */
-		free(learn->hidden_weight[i]);
-		free(learn->hidden_delta[i]);
+		/* Free storage of hidden weights */
+		free(learn->hidden_weight[0]);
+		free(learn->hidden_delta[0]);
+
+		/* Free storage of output weights */
+		free(learn->output_weight[0]);
+		free(learn->output_delta[0]);
 	}
 
 	/* Free list of rows */
 	free(learn->hidden_weight);
 	free(learn->hidden_delta);
 
-	/* Free rows of output weights */
-	for (i = 0; i < learn->num_hidden + 1; i++)
-	{
-		/* Free weight row */
-		free(learn->output_weight[i]);
-		free(learn->output_delta[i]);
-	}
-
 	/* Free list of rows */
 	free(learn->output_weight);
 	free(learn->output_delta);
 
-	/* Clear old past input sets */
-	clear_store(learn);
+	/* Free default delta and list of inputs with deltas */
+	free(learn->default_delta);
+	free(learn->touched_input);
+	free(learn->input_touched);
+
+	/* Free past input lists */
+	for (i = 0; i < PAST_MAX; i++)
+	{
+		/* Free lists of slot */
+		free(learn->past_index[i]);
+		free(learn->past_value[i]);
+	}
 
-	/* Free list of past inputs */
-	free(learn->past_input);
+	/* Free ring buffer of past inputs */
+	free(learn->past_index);
+	free(learn->past_value);
+	free(learn->past_count);
+	free(learn->past_size);
 	free(learn->past_input_player);
 
 	/* Free input names */
@@ -22,6 +22,54 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#ifdef WIN32
+#include "stdint.h"
+#else
+#include <stdint.h>
+#endif
+
+/*
+ * Value of inputs not explicitly set when using sparse inputs.
+ */
+#define DEFAULT_INPUT -1.0
+
+/*
+ * Maximum depth of the stack of saved hidden node sums.
+ */
+#define NET_STACK_MAX 16
+
+/*
+ * Saved hidden node sums, with the sparse inputs they were computed from.
+ */
+typedef struct net_acc
+{
+	/* Hidden node sums */
+	double *hidden_sum;
+
+	/* Active inputs and their values */
+	int *active_index;
+	double *active_value;
+	int num_active;
+
+	/* Saved sums are usable */
+	int valid;
+
+} net_acc;
+
+/*
+ * A training position read from a recorded dataset.
+ */
+typedef struct net_sample
+{
+	/* Desired outputs */
+	double *desired;
+
+	/* Active inputs and their values */
+	unsigned short *index;
+	float *value;
+	int num_active;
+
+} net_sample;
 
 /*
  * A two-layer neural net.
@@ -52,24 +100,72 @@ typedef struct net
 	/* Accumulated deltas to hidden weights */
 	double **hidden_delta;
 
+	/* Accumulated delta to every input's hidden weights */
+	double *default_delta;
+
+	/* Default delta is not zero */
+	int default_touched;
+
+	/* Inputs (and bias) whose hidden weight deltas are not zero */
+	int *touched_input;
+	int num_touched;
+
+	/* Whether each input is in the list above */
+	char *input_touched;
+
+	/* Any hidden weight delta may be non-zero */
+	int all_touched;
+
 	/* Output layer weights */
 	double **output_weight;
 
 	/* Accumulated deltas to output weights */
 	double **output_delta;
 
+	/* Weights belong to another network and deltas are applied to them */
+	int shared_weights;
+
 	/* Hidden node sums */
 	double *hidden_sum;
 
 	/* Cumulative hidden node error */
 	double *hidden_error;
 
+	/* Scratch space used while training */
+	double *hidden_corr;
+	double *weighted_prob;
+	double *output_error;
+	double *output_deriv;
+	double *output_corr;
+
 	/* Set of input values */
 	double *input_value;
 
 	/* Previous input values */
 	double *prev_input;
 
+	/* Active (non-default) inputs set since last clear */
+	int *active_index;
+	int num_active;
+
+	/* Active inputs as of last sparse computation */
+	int *prev_active;
+	int num_prev_active;
+
+	/* Previous active inputs are the only non-default previous inputs */
+	int prev_active_valid;
+
+	/* Round in which each input was last set, and current round */
+	uint32_t *input_round;
+	uint32_t cur_round;
+
+	/* List of inputs changed since last computation */
+	int *changed_input;
+
+	/* Stack of saved hidden node sums */
+	net_acc acc_stack[NET_STACK_MAX];
+	int acc_depth;
+
 	/* Set of hidden results */
 	double *hidden_result;
 
@@ -82,12 +178,20 @@ typedef struct net
 	/* Sum that we divide results by to get probablities */
 	double prob_sum;
 
-	/* Sets of past inputs */
-	double **past_input;
+	/* Ring buffer of past sparse input sets (index and value lists) */
+	int **past_index;
+	double **past_value;
+
+	/* Number of inputs in each past set, and room allocated for them */
+	int *past_count;
+	int *past_size;
 
 	/* Player who created past inputs */
 	int *past_input_player;
 
+	/* Position of oldest past input set in ring buffer */
+	int past_start;
+
 	/* Number of past input sets available */
 	int num_past;
 
@@ -103,7 +207,23 @@ typedef struct net
 extern void make_learner(net *learn, int inputs, int hidden, int output);
 extern void random_net(net *learn);
 extern void compute_net(net *learn);
+extern void clear_inputs(net *learn);
+extern void set_input(net *learn, int i, double value);
+extern void compute_net_sparse(net *learn);
+extern void push_net(net *learn);
+extern void pop_net(net *learn);
+extern void set_net_depth(net *learn, int depth);
 extern void store_net(net *learn, int who);
+extern int past_player(net *learn, int k);
+extern void load_past(net *learn, int k);
+extern void write_samples(net *learn, FILE *fff, int who, double *desired);
+extern int read_sample(net *learn, FILE *fff, net_sample *s_ptr);
+extern void free_sample(net_sample *s_ptr);
+extern void train_sample(net *learn, net_sample *s_ptr);
+extern void copy_weights(net *dest, net *src);
+extern void add_deltas(net *dest, net *src);
+extern void share_weights(net *dest, net *src);
+extern void clear_sums(net *learn);
 extern void clear_store(net *learn);
 extern void train_net(net *learn, double lambda, double *desired);
 extern void apply_training(net *learn);
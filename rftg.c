@@ -73,6 +73,11 @@ char *pending_save_filename = NULL;
  */
 static game real_game;
 
+/*
+ * Log of events in the real game.
+ */
+static event_log real_events;
+
 /*
  * Current undo position.
  */
@@ -2121,6 +2126,9 @@ static void run_game(void)
 				/* We're not replaying - we're continuing a loaded game */
 				game_replaying = FALSE;
 				
+				/* Record game events */
+				start_events(&real_game, &real_events);
+
 				/* Skip replaying - jump directly to playing the loaded game */
 				goto play_loaded_game;
 			}
@@ -2258,6 +2266,9 @@ static void run_game(void)
 		/* Clear restart loop flag */
 		restart_loop = 0;
 
+		/* Record game events */
+		start_events(&real_game, &real_events);
+
 		/* Begin game */
 		begin_game(&real_game);
 
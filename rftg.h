@@ -80,6 +80,16 @@
  */
 #define MAX_DECK 328
 
+/*
+ * Number of 64-bit words in a set of cards.
+ */
+#define CARD_WORDS ((MAX_DECK + 63) / 64)
+
+/*
+ * Number of 64-bit words in a set of card designs.
+ */
+#define DESIGN_WORDS ((AVAILABLE_DESIGN + 63) / 64)
+
 /*
  * Number of powers per card.
  */
@@ -569,6 +579,21 @@
 #define FORMAT_DISCARD "discard"
 #define FORMAT_DEBUG "debug"
 
+/*
+ * Game event types.
+ */
+#define EVENT_ROUND     0
+#define EVENT_PHASE     1
+#define EVENT_MOVE      2
+#define EVENT_VP        3
+#define EVENT_CHOICE    4
+#define EVENT_GAME_OVER 5
+
+/*
+ * Number of events kept in an event log (must be a power of two).
+ */
+#define EVENT_LOG_SIZE 4096
+
 /*
  * Forward declaration.
  */
@@ -673,6 +698,25 @@ typedef struct design
 
 } design;
 
+/*
+ * Summary of a design's powers, packed for fast scans of tableaus.
+ */
+typedef struct power_table
+{
+	/* Codes of powers in each phase OR'ed together */
+	uint64_t code[MAX_PHASE];
+
+	/* Bit for each phase with powers */
+	uint8_t phase_mask;
+
+	/* Number of powers in each phase */
+	uint8_t num[MAX_PHASE];
+
+	/* Index of each power in each phase, in card order */
+	uint8_t index[MAX_PHASE][MAX_POWER];
+
+} power_table;
+
 /*
  * Information about an instance of a card.
  */
@@ -785,6 +829,42 @@ typedef struct player
 	/* Player's first card of each location as of the start of the phase */
 	int16_t start_head[MAX_WHERE];
 
+	/* Sets of cards in hand and active area (kept by move_card) */
+	uint64_t hand_bits[CARD_WORDS];
+	uint64_t active_bits[CARD_WORDS];
+
+	/* Set of designs of active cards */
+	uint64_t active_design[DESIGN_WORDS];
+
+	/* Set of active cards as of the start of the phase */
+	uint64_t start_active_bits[CARD_WORDS];
+
+	/* Number of cards active at start of phase with each flag bit */
+	int8_t start_flag_count[32];
+
+	/* Counts of active cards used for goal progress (kept by move_card) */
+	int8_t goal_worlds;
+	int8_t goal_devels;
+	int8_t goal_six_devels;
+	int8_t goal_production;
+	int8_t goal_good_type[MAX_GOOD];
+	int8_t goal_phase[6];
+
+	/* Printed VP of active cards (kept by move_card) */
+	int16_t card_vp;
+
+	/* VP from active cards' bonuses for other active cards */
+	int16_t bonus_vp;
+
+	/* Power version of game when military strength was last computed */
+	uint32_t mil_version;
+
+	/* Non-specific military strength */
+	int8_t mil_total;
+
+	/* Extra military against worlds by good type, Rebel flag and defense */
+	int8_t mil_against[MAX_GOOD][2][2];
+
 	/* Card chosen in Develop or Settle phase */
 	int16_t placing;
 
@@ -920,6 +1000,9 @@ typedef struct game
 	/* Session ID in online server */
 	int session_id;
 
+	/* Log of game events (if any) */
+	struct event_log *events;
+
 	/* Current random seed */
 	unsigned int random_seed;
 
@@ -932,6 +1015,9 @@ typedef struct game
 	/* Who initiated the simulation */
 	int8_t sim_who;
 
+	/* Depth of nested simulations (0 for real game) */
+	int8_t sim_depth;
+
 	/* Name of human player */
 	char *human_name;
 
@@ -962,6 +1048,16 @@ typedef struct game
 	/* Information about each card */
 	card deck[MAX_DECK];
 
+	/* Sets of cards in draw and discard piles */
+	uint64_t draw_bits[CARD_WORDS];
+	uint64_t discard_bits[CARD_WORDS];
+
+	/* Number of cards in draw pile */
+	int16_t num_draw;
+
+	/* Changed whenever active cards or their used powers change */
+	uint32_t power_version;
+
 	/* Victory points remaining in the pool */
 	int8_t vp_pool;
 
@@ -1068,11 +1164,69 @@ typedef struct campaign_status
 } campaign_status;
 
 
+/*
+ * State of one stream of random numbers.
+ */
+typedef struct rng_stream
+{
+	/* Generator state */
+	uint32_t s[4];
+
+} rng_stream;
+
+/*
+ * One game event.
+ *
+ * The meaning of the arguments depends on the type:
+ *
+ *   EVENT_ROUND      round number
+ *   EVENT_PHASE      action
+ *   EVENT_MOVE       card, old owner, old location, new location
+ *   EVENT_VP         VP gained, VP left in pool
+ *   EVENT_CHOICE     choice type, return value, number of items
+ *   EVENT_GAME_OVER  final score, winner flag
+ *
+ * Unused arguments are zero.
+ */
+typedef struct game_event
+{
+	/* Type of event */
+	uint8_t type;
+
+	/* Player involved (or -1 for none) */
+	int8_t who;
+
+	/* Round and current action when event occurred */
+	int8_t round;
+	int8_t action;
+
+	/* Event arguments */
+	int16_t arg[4];
+
+} game_event;
+
+/*
+ * Ring buffer of game events.
+ *
+ * Events are numbered from the start of the game, and event n is kept
+ * in slot n modulo EVENT_LOG_SIZE until it is overwritten.
+ */
+typedef struct event_log
+{
+	/* Events */
+	game_event event[EVENT_LOG_SIZE];
+
+	/* Number of events added */
+	uint32_t head;
+
+} event_log;
+
 /*
  * External variables.
  */
 extern int num_design;
 extern design library[AVAILABLE_DESIGN];
+extern power_table power_info[AVAILABLE_DESIGN];
 extern campaign *camp_library;
 extern int num_campaign;
 extern char *actname[MAX_ACTION * 2 - 1];
@@ -1084,6 +1238,8 @@ extern char *exp_names[MAX_EXPANSION + 1];
 extern char *player_labels[MAX_PLAYER];
 extern char *location_names[9];
 extern decisions ai_func;
+extern FILE *ai_record;
+extern long ai_num_sim;
 extern decisions gui_func;
 
 /*
@@ -1146,6 +1302,11 @@ extern void read_campaign(void);
 extern void apply_campaign(game *g);
 extern void init_game(game *g);
 extern int simple_rand(unsigned int *seed);
+extern void rng_seed(rng_stream *r, uint64_t seed, uint64_t stream);
+extern uint32_t rng_next(rng_stream *r);
+extern uint32_t rng_below(rng_stream *r, uint32_t n);
+extern void rng_fill_below(rng_stream *r, uint32_t out[], int count,
+                           uint32_t n);
 extern int next_choice(int* log, int pos);
 extern void perform_debug_moves(game *g, int who);
 extern int count_player_area(game *g, int who, int where);
@@ -1155,8 +1316,13 @@ extern int player_chose(game *g, int who, int act);
 extern int prestige_on_tile(game *g, int who);
 extern int random_draw(game *g);
 extern int first_draw(game *g);
+extern void start_events(game *g, event_log *l_ptr);
+extern game_event *next_event(game *g, uint32_t *pos);
+extern void format_event(game *g, game_event *e, char *buf);
 extern void move_card(game *g, int which, int who, int where);
 extern void move_start(game *g, int which, int who, int where);
+extern void clear_card_sets(player *p_ptr);
+extern void rebuild_piles(game *g);
 extern int draw_card(game *g, int who, char *reason);
 extern void draw_cards(game *g, int who, int num, char *reason);
 extern void start_prestige(game *g);
@@ -1290,6 +1456,7 @@ extern void declare_winner(game *g);
 extern void ai_debug(game *g, double win_prob[MAX_PLAYER][MAX_PLAYER],
                               double *role[], double *action_score[],
                               int *num_action);
+extern double ai_playout(game *g, int who, double result[MAX_PLAYER]);
 
 extern int load_game(game *g, char *filename);
 extern int save_game(game *g, char *filename, int player_us);
@@ -22,8 +22,15 @@
 
 #include "rftg.h"
 #include "comm.h"
+#ifdef STUB_DB
+#include "dbstub.h"
+#else
 #include <mysql/mysql.h>
+#endif
 #include <pthread.h>
+#include <semaphore.h>
+#include <ucontext.h>
+#include <sys/uio.h>
 
 /*
  * Server settings.
@@ -46,6 +53,60 @@
  */
 #define MAX_RAND     1024
 
+/*
+ * Size of each pooled outgoing data chunk.
+ */
+#define OUT_CHUNK_SIZE 4096
+
+/*
+ * Maximum number of chunks to send with one writev() call.
+ */
+#define MAX_OUT_IOV    64
+
+/*
+ * Maximum number of free chunks to keep around for reuse.
+ */
+#define MAX_OUT_FREE   256
+
+/*
+ * Maximum number of unsent bytes allowed before a client is dropped.
+ */
+#define MAX_OUT_BACKLOG (1024 * 1024)
+
+/*
+ * Maximum number of sessions.
+ */
+#define MAX_SESSION    1024
+
+/*
+ * Maximum number of game worker threads.
+ */
+#define MAX_WORKER     64
+
+/*
+ * Size of stack given to each running game.
+ */
+#define GAME_STACK_SIZE (256 * 1024)
+
+
+/*
+ * A chunk of outgoing data waiting to be sent to a client.
+ */
+typedef struct out_chunk
+{
+	/* Next chunk in queue (or in free list) */
+	struct out_chunk *next;
+
+	/* Position of first unsent byte */
+	int start;
+
+	/* Amount of data stored in chunk */
+	int len;
+
+	/* Data */
+	char data[OUT_CHUNK_SIZE];
+
+} out_chunk;
 
 /*
  * A connection from a client.
@@ -64,14 +125,18 @@ typedef struct conn
 	/* Amount of data currently in buffer */
 	int buf_full;
 
-	/* Data buffer for unsent messages */
-	char *out_buf;
+	/* Queue of chunks holding unsent messages */
+	out_chunk *out_head;
+	out_chunk *out_tail;
 
 	/* Amount of data needing to be sent */
 	int out_len;
 
-	/* Current size of outgoing buffer */
-	int out_size;
+	/* Outgoing backlog grew too large and connection must be dropped */
+	int out_overflow;
+
+	/* Sending failed and connection must be dropped */
+	int out_error;
 
 	/* Connection state */
 	int state;
@@ -172,6 +237,9 @@ typedef struct session
 	/* Current position in random pool */
 	int random_pos;
 
+	/* Random numbers to use after pool is used up */
+	rng_stream random_stream;
+
 	/* User ID who created session */
 	int created;
 
@@ -214,8 +282,41 @@ typedef struct session
 	/* Mutex for access to session variables */
 	pthread_mutex_t session_mutex;
 
-	/* Condition variable to signal game thread when reply is ready */
-	pthread_cond_t wait_cond;
+	/* Saved execution state of game while waiting for replies */
+	ucontext_t game_ctx;
+
+	/* Stack of running game (if any) */
+	char *game_stack;
+
+	/* Game has finished running */
+	int game_done;
+
+	/* Session is in its worker's queue to be resumed */
+	int queued;
+
+	/* Lobby messages about this session as seen by uninvolved clients */
+	char lobby_msg[4096];
+	int lobby_len;
+
+	/* Cached lobby messages are up to date */
+	int lobby_valid;
+
+	/* Game ID whose message history is cached (-1 if none) */
+	int hist_gid;
+
+	/* Encoded log messages of game */
+	char *hist_buf;
+	int hist_len;
+	int hist_size;
+
+	/* Position in encoded log and user allowed to see each message */
+	int *hist_pos;
+	int *hist_uid;
+	int hist_num;
+	int hist_max;
+
+	/* Mutex protecting message history */
+	pthread_mutex_t hist_mutex;
 
 	/* Time since last player joined */
 	time_t last_join;
@@ -232,9 +333,80 @@ static int num_conn;
 /*
  * List of active game sessions.
  */
-static session s_list[1024];
+static session s_list[MAX_SESSION];
 static int num_session;
 
+/*
+ * A thread that runs the games of a fixed share of sessions.
+ *
+ * Games run as coroutines on their own small stacks.  When a game must
+ * wait for a reply it switches back to its worker, which goes on to run
+ * other games.  The network thread places the IDs of sessions that have
+ * new input on the worker's queue.
+ */
+typedef struct worker
+{
+	/* Thread running games */
+	pthread_t thread;
+
+	/* Context to return to when a game waits or finishes */
+	ucontext_t ctx;
+
+	/* Queue of session IDs to resume */
+	int queue[MAX_SESSION];
+
+	/* Positions of next session to take and next free slot */
+	unsigned int head;
+	unsigned int tail;
+
+	/* Number of sessions in queue */
+	sem_t ready;
+
+} worker;
+
+/*
+ * Game worker threads.
+ */
+static worker w_list[MAX_WORKER];
+
+/*
+ * Number of game worker threads.
+ */
+static int num_worker = 4;
+
+/*
+ * Encoded messages about all open sessions, as seen by uninvolved clients.
+ */
+static char *lobby_buf;
+static int lobby_len, lobby_size;
+
+/*
+ * Cached open session messages are up to date.
+ */
+static int lobby_valid;
+
+/*
+ * Encoded messages about all connected players.
+ */
+static char *players_buf;
+static int players_len, players_size;
+
+/*
+ * Cached player messages are up to date.
+ */
+static int players_valid;
+
+/*
+ * Pool of free outgoing data chunks.
+ */
+static out_chunk *out_free;
+static int num_out_free;
+
+/*
+ * Mutex to protect pool of free chunks.
+ */
+static pthread_mutex_t out_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 /*
  * Tick size (in seconds).
  */
@@ -537,6 +709,10 @@ static void db_load_sessions(void)
 		/* Initialize session mutex */
 		pthread_mutex_init(&s_ptr->session_mutex, NULL);
 
+		/* Initialize message history */
+		pthread_mutex_init(&s_ptr->hist_mutex, NULL);
+		s_ptr->hist_gid = -1;
+
 		/* Read fields */
 		s_ptr->gid = strtol(row[0], NULL, 0);
 		strcpy(s_ptr->desc, row[1]);
@@ -677,6 +853,28 @@ static void db_leave_game(int uid, int gid)
 	mysql_query(mysql, query);
 }
 
+/*
+ * Seed a session's random stream from its pool of random bytes.
+ *
+ * The stream is used once the pool runs out, so replaying a game from
+ * its saved pool gives the same numbers.
+ */
+static void seed_random_stream(session *s_ptr)
+{
+	uint64_t seed = 0xcbf29ce484222325ULL;
+	int i;
+
+	/* Hash pool bytes */
+	for (i = 0; i < MAX_RAND; i++)
+	{
+		/* Mix in byte */
+		seed = (seed ^ s_ptr->random_pool[i]) * 0x100000001b3ULL;
+	}
+
+	/* Start stream */
+	rng_seed(&s_ptr->random_stream, seed, 0);
+}
+
 /*
  * Load a game's saved state from the database.
  *
@@ -716,6 +914,9 @@ static int db_load_game_state(int sid)
 	/* Start at beginning of byte pool */
 	s_ptr->random_pos = 0;
 
+	/* Seed stream for use after pool */
+	seed_random_stream(s_ptr);
+
 	/* Free result */
 	mysql_free_result(res);
 
@@ -1034,15 +1235,134 @@ static void db_save_results(int sid)
 }
 
 /*
- * Saves a game message to the database.
+ * Forward declaration.
+ */
+static void send_data(int cid, char *data, int size);
+
+/*
+ * Free the cached message history of a session.
+ *
+ * The history mutex must be held.
+ */
+static void clear_history(session *s_ptr)
+{
+	/* Free buffers */
+	free(s_ptr->hist_buf);
+	free(s_ptr->hist_pos);
+	free(s_ptr->hist_uid);
+
+	/* Clear pointers and sizes */
+	s_ptr->hist_buf = NULL;
+	s_ptr->hist_pos = s_ptr->hist_uid = NULL;
+	s_ptr->hist_len = s_ptr->hist_size = 0;
+	s_ptr->hist_num = s_ptr->hist_max = 0;
+
+	/* No game history cached */
+	s_ptr->hist_gid = -1;
+}
+
+/*
+ * Encode a game message and add it to a session's cached history.
+ *
+ * The user name is only needed for chat messages.
+ *
+ * The history mutex must be held.
+ */
+static void history_add(session *s_ptr, int uid, char *user, char *txt,
+                        char *tag)
+{
+	char msg[1024], *ptr = msg;
+	int size;
+
+	/* Check for no format */
+	if (!strlen(tag))
+	{
+		/* Create log message */
+		start_msg(&ptr, MSG_LOG);
+
+		/* Add text of message */
+		put_string(txt, &ptr);
+	}
+
+	/* Check for chat message */
+	else if (!strcmp(tag, FORMAT_CHAT))
+	{
+		/* Create chat message */
+		start_msg(&ptr, MSG_GAMECHAT);
+
+		/* Copy user sending chat to message */
+		put_string(user, &ptr);
+
+		/* Copy chat text to message */
+		put_string(txt, &ptr);
+
+		/* Chat is seen by everyone */
+		uid = -1;
+	}
+
+	/* Formatted message */
+	else
+	{
+		/* Create log message */
+		start_msg(&ptr, MSG_LOG);
+
+		/* Add text of message */
+		put_string(txt, &ptr);
+
+		/* Add format of message */
+		put_string(tag, &ptr);
+	}
+
+	/* Finish message */
+	finish_msg(msg, ptr);
+
+	/* Get message size */
+	size = ptr - msg;
+
+	/* Check for insufficient room in buffer */
+	if (s_ptr->hist_len + size > s_ptr->hist_size)
+	{
+		/* Grow buffer */
+		s_ptr->hist_size = 2 * s_ptr->hist_size + size + 4096;
+		s_ptr->hist_buf = (char *)realloc(s_ptr->hist_buf,
+		                                  s_ptr->hist_size);
+	}
+
+	/* Check for insufficient room in message list */
+	if (s_ptr->hist_num == s_ptr->hist_max)
+	{
+		/* Grow lists */
+		s_ptr->hist_max = 2 * s_ptr->hist_max + 256;
+		s_ptr->hist_pos = (int *)realloc(s_ptr->hist_pos,
+		                                 sizeof(int) * s_ptr->hist_max);
+		s_ptr->hist_uid = (int *)realloc(s_ptr->hist_uid,
+		                                 sizeof(int) * s_ptr->hist_max);
+	}
+
+	/* Remember message position and who may see it */
+	s_ptr->hist_pos[s_ptr->hist_num] = s_ptr->hist_len;
+	s_ptr->hist_uid[s_ptr->hist_num] = uid;
+	s_ptr->hist_num++;
+
+	/* Copy encoded message */
+	memcpy(s_ptr->hist_buf + s_ptr->hist_len, msg, size);
+	s_ptr->hist_len += size;
+}
+
+/*
+ * Save a game message to the database.
+ *
+ * The user name is only needed for chat messages.
  */
-static void db_save_message(int sid, int uid, char* txt, char* tag)
+static void db_save_message(int sid, int uid, char *user, char* txt,
+                            char* tag)
 {
+	session *s_ptr = &s_list[sid];
 	char query[1024];
 	char etxt[1024], etag[1024];
 
 	/* Do not save message if game is replaying */
-	if (s_list[sid].replaying) return;
+	if (s_ptr->replaying) return;
 
 	/* Escape message and format */
 	mysql_real_escape_string(mysql, etxt, txt, strlen(txt));
@@ -1051,7 +1371,10 @@ static void db_save_message(int sid, int uid, char* txt, char* tag)
 	/* Create insertion query */
 	sprintf(query, "INSERT INTO messages (gid, uid, message, format) \
 	                VALUES (%d, %d, '%s', '%s')",
-	        s_list[sid].gid, uid, etxt, etag);
+	        s_ptr->gid, uid, etxt, etag);
+
+	/* Grab history mutex */
+	pthread_mutex_lock(&s_ptr->hist_mutex);
 
 	/* Send query */
 	mysql_query(mysql, query);
@@ -1063,24 +1386,37 @@ static void db_save_message(int sid, int uid, char* txt, char* tag)
 		server_log("%s", mysql_error(mysql));
 		exit(1);
 	}
+
+	/* Add to cached history if loaded */
+	if (s_ptr->hist_gid == s_ptr->gid)
+	{
+		/* Add message */
+		history_add(s_ptr, uid, user, txt, tag);
+	}
+
+	/* Release history mutex */
+	pthread_mutex_unlock(&s_ptr->hist_mutex);
 }
 
 /*
- * Replays game messages to a client.
+ * Load a session's message history from the database.
+ *
+ * The history mutex must be held.
  */
-static void replay_messages(int gid, int cid)
+static void db_load_history(int sid)
 {
+	session *s_ptr = &s_list[sid];
 	MYSQL_RES *res;
 	MYSQL_ROW row;
 	char query[1024];
-	char msg[1024], name[1024], *ptr;
+
+	/* Discard any old history */
+	clear_history(s_ptr);
 
 	/* Create lookup query */
-	sprintf(query, "SELECT message, format, user "
+	sprintf(query, "SELECT message, format, user, uid "
 	               "FROM messages LEFT JOIN users USING (uid) "
-	               "WHERE gid=%d AND (uid=%d OR uid=-1 OR format='%s') "
-	               "ORDER BY mid",
-	               gid, c_list[cid].uid, FORMAT_CHAT);
+	               "WHERE gid=%d ORDER BY mid", s_ptr->gid);
 
 	/* Run query */
 	mysql_query(mysql, query);
@@ -1091,87 +1427,242 @@ static void replay_messages(int gid, int cid)
 	/* Loop over rows returned */
 	while ((row = mysql_fetch_row(res)))
 	{
-		/* Reset message */
-		ptr = msg;
+		/* Add message to history */
+		history_add(s_ptr, strtol(row[3], NULL, 0),
+		            row[2] ? row[2] : "", row[0], row[1]);
+	}
 
-		/* Check for no format */
-		if (!strlen(row[1]))
-		{
-			/* Create log message */
-			start_msg(&ptr, MSG_LOG);
+	/* Free results */
+	mysql_free_result(res);
 
-			/* Add text of message */
-			put_string(row[0], &ptr);
+	/* Mark history as loaded */
+	s_ptr->hist_gid = s_ptr->gid;
+}
 
-			/* Finish message */
-			finish_msg(msg, ptr);
+/*
+ * Replays game messages to a client.
+ *
+ * The session's history is loaded from the database once, and afterwards
+ * kept up to date as messages are saved.  Runs of messages the client may
+ * see are sent as single buffers.
+ */
+static void replay_messages(int sid, int cid)
+{
+	session *s_ptr = &s_list[sid];
+	int uid = c_list[cid].uid;
+	int i, j, end;
 
-			/* Send to client */
-			send_msg(cid, msg);
+	/* Grab history mutex */
+	pthread_mutex_lock(&s_ptr->hist_mutex);
+
+	/* Load history if not already cached */
+	if (s_ptr->hist_gid != s_ptr->gid) db_load_history(sid);
+
+	/* Loop over messages */
+	for (i = 0; i < s_ptr->hist_num; i = j)
+	{
+		/* Look for end of run of messages client may see */
+		for (j = i; j < s_ptr->hist_num; j++)
+		{
+			/* Stop at message for someone else */
+			if (s_ptr->hist_uid[j] != -1 &&
+			    s_ptr->hist_uid[j] != uid) break;
 		}
 
-		/* Check for chat message */
-		else if (!strcmp(row[1], FORMAT_CHAT))
+		/* Check for run of visible messages */
+		if (j > i)
 		{
-			/* Check for global message */
-			if (!row[2])
-			{
-				/* Set empty user name */
-				strcpy(name, "");
-			}
-			else
-			{
-				/* Copy user name */
-				strcpy(name, row[2]);
-			}
+			/* Find end of run */
+			end = j < s_ptr->hist_num ? s_ptr->hist_pos[j] :
+			                            s_ptr->hist_len;
 
-			/* Create log message */
-			start_msg(&ptr, MSG_GAMECHAT);
+			/* Send messages */
+			send_data(cid, s_ptr->hist_buf + s_ptr->hist_pos[i],
+			          end - s_ptr->hist_pos[i]);
+		}
 
-			/* Copy user sending chat to message */
-			put_string(name, &ptr);
+		/* Skip hidden message */
+		else j++;
+	}
 
-			/* Copy chat text to message */
-			put_string(row[0], &ptr);
+	/* Release history mutex */
+	pthread_mutex_unlock(&s_ptr->hist_mutex);
+}
 
-			/* Finish message */
-			finish_msg(msg, ptr);
+/*
+ * Get an empty outgoing data chunk, reusing one from the pool if possible.
+ */
+static out_chunk *alloc_chunk(void)
+{
+	out_chunk *o_ptr;
 
-			/* Send to client */
-			send_msg(cid, msg);
+	/* Grab pool mutex */
+	pthread_mutex_lock(&out_pool_mutex);
+
+	/* Check for free chunk available */
+	if (out_free)
+	{
+		/* Take first free chunk */
+		o_ptr = out_free;
+		out_free = o_ptr->next;
+		num_out_free--;
+	}
+	else
+	{
+		/* Allocate new chunk */
+		o_ptr = (out_chunk *)malloc(sizeof(out_chunk));
+	}
+
+	/* Release pool mutex */
+	pthread_mutex_unlock(&out_pool_mutex);
+
+	/* Clear chunk */
+	o_ptr->next = NULL;
+	o_ptr->start = o_ptr->len = 0;
+
+	/* Return chunk */
+	return o_ptr;
+}
+
+/*
+ * Return an outgoing data chunk to the pool.
+ */
+static void free_chunk(out_chunk *o_ptr)
+{
+	/* Grab pool mutex */
+	pthread_mutex_lock(&out_pool_mutex);
+
+	/* Check for room in pool */
+	if (num_out_free < MAX_OUT_FREE)
+	{
+		/* Add to free list */
+		o_ptr->next = out_free;
+		out_free = o_ptr;
+		num_out_free++;
+		o_ptr = NULL;
+	}
+
+	/* Release pool mutex */
+	pthread_mutex_unlock(&out_pool_mutex);
+
+	/* Free chunk if pool was full */
+	free(o_ptr);
+}
+
+/*
+ * Discard all unsent data for a connection.
+ *
+ * The connection mutex must be held.
+ */
+static void clear_out_queue(conn *c)
+{
+	out_chunk *o_ptr;
+
+	/* Loop over queued chunks */
+	while (c->out_head)
+	{
+		/* Remove first chunk */
+		o_ptr = c->out_head;
+		c->out_head = o_ptr->next;
+
+		/* Return chunk to pool */
+		free_chunk(o_ptr);
+	}
+
+	/* Queue is now empty */
+	c->out_tail = NULL;
+	c->out_len = 0;
+}
+
+/*
+ * Send as much unsent data as the socket will accept.
+ *
+ * The connection mutex must be held.
+ */
+static void flush_conn(conn *c)
+{
+	struct iovec iov[MAX_OUT_IOV];
+	out_chunk *o_ptr;
+	int n, x;
+
+	/* Loop until all data is sent */
+	while (c->out_len > 0)
+	{
+		/* Gather unsent data from queued chunks */
+		for (o_ptr = c->out_head, n = 0; o_ptr && n < MAX_OUT_IOV;
+		     o_ptr = o_ptr->next, n++)
+		{
+			/* Point to unsent portion of chunk */
+			iov[n].iov_base = o_ptr->data + o_ptr->start;
+			iov[n].iov_len = o_ptr->len - o_ptr->start;
 		}
 
-		/* Formatted message */
-		else
+		/* Attempt to send everything gathered */
+		x = writev(c->fd, iov, n);
+
+		/* Check for errors */
+		if (x < 0)
 		{
-			/* Create log message */
-			start_msg(&ptr, MSG_LOG);
+			/* Check for try again error */
+			if (errno == EAGAIN || errno == EWOULDBLOCK) return;
 
-			/* Add text of message */
-			put_string(row[0], &ptr);
+			/* Check for interrupted call */
+			if (errno == EINTR) continue;
 
-			/* Add format of message */
-			put_string(row[1], &ptr);
+			/* Print message */
+			server_log("Write to connection %d failed: %s",
+			           (int)(c - c_list), strerror(errno));
 
-			/* Finish message */
-			finish_msg(msg, ptr);
+			/* Discard unsent data */
+			clear_out_queue(c);
 
-			/* Send to client */
-			send_msg(cid, msg);
+			/* Mark connection to be dropped by main loop */
+			c->out_error = 1;
+			return;
 		}
-	}
 
-	/* Free results */
-	mysql_free_result(res);
+		/* Reduce amount of data needing to be sent */
+		c->out_len -= x;
+
+		/* Consume sent data from front of queue */
+		while (x > 0)
+		{
+			/* Get first chunk */
+			o_ptr = c->out_head;
+
+			/* Check for chunk only partially sent */
+			if (o_ptr->len - o_ptr->start > x)
+			{
+				/* Advance start of unsent data */
+				o_ptr->start += x;
+				break;
+			}
+
+			/* Remove amount sent from this chunk */
+			x -= o_ptr->len - o_ptr->start;
+
+			/* Remove chunk from queue */
+			c->out_head = o_ptr->next;
+			if (!c->out_head) c->out_tail = NULL;
+
+			/* Return chunk to pool */
+			free_chunk(o_ptr);
+		}
+	}
 }
 
 /*
- * Send a message to a client.
+ * Send already encoded data (one or more messages) to a client.
+ *
+ * The data is appended to the connection's queue of outgoing chunks,
+ * and sent immediately if nothing else is waiting to be sent.  Otherwise
+ * it is sent by the main loop once the socket is writable.
  */
-void send_msg(int cid, char *msg)
+static void send_data(int cid, char *data, int size)
 {
 	conn *c;
-	int size, x;
+	out_chunk *o_ptr;
+	int x, was_empty;
 	char *ptr;
 
 	/* Ensure valid connection */
@@ -1183,60 +1674,93 @@ void send_msg(int cid, char *msg)
 	/* Check for kicked player */
 	if (c->fd < 0) return;
 
-	/* Go to size area of message */
-	ptr = msg + 4;
-
-	/* Read size */
-	size = get_integer(&ptr);
-
 	/* Grab mutex for connection */
 	pthread_mutex_lock(&c->conn_mutex);
 
-	/* Check for insufficient buffer size to hold message */
-	if (c->out_size < c->out_len + size)
+	/* Check for connection closed, already overflowed or failed */
+	if (c->fd < 0 || c->out_overflow || c->out_error)
 	{
-		/* Reallocate buffer */
-		c->out_buf = (char *)realloc(c->out_buf, c->out_len + size);
+		/* Release mutex */
+		pthread_mutex_unlock(&c->conn_mutex);
+		return;
 	}
 
-	/* Copy current message to end of buffer */
-	memcpy(c->out_buf + c->out_len, msg, size);
+	/* Check for client not keeping up with data sent */
+	if (c->out_len + size > MAX_OUT_BACKLOG)
+	{
+		/* Print message */
+		server_log("Output backlog of connection %d exceeded", cid);
 
-	/* Add to current buffer length */
-	c->out_len += size;
+		/* Discard unsent data */
+		clear_out_queue(c);
 
-	/* Attempt to send full amount of buffer */
-	x = send(c->fd, c->out_buf, c->out_len, 0);
+		/* Mark connection to be dropped by main loop */
+		c->out_overflow = 1;
 
-	/* Check for errors */
-	if (x < 0)
+		/* Release mutex */
+		pthread_mutex_unlock(&c->conn_mutex);
+		return;
+	}
+
+	/* Remember whether data was already waiting */
+	was_empty = c->out_len == 0;
+
+	/* Start at beginning of data */
+	ptr = data;
+
+	/* Copy data into queued chunks */
+	while (size > 0)
 	{
-		/* Check for try again error */
-		if (errno == EAGAIN || errno == EWOULDBLOCK)
+		/* Get last chunk in queue */
+		o_ptr = c->out_tail;
+
+		/* Check for no room in last chunk */
+		if (!o_ptr || o_ptr->len == OUT_CHUNK_SIZE)
 		{
-			/* Release mutex */
-			pthread_mutex_unlock(&c->conn_mutex);
-			return;
+			/* Get new chunk */
+			o_ptr = alloc_chunk();
+
+			/* Add to end of queue */
+			if (c->out_tail) c->out_tail->next = o_ptr;
+			else c->out_head = o_ptr;
+			c->out_tail = o_ptr;
 		}
 
-		/* Print error */
-		perror("send");
+		/* Compute amount to copy into this chunk */
+		x = OUT_CHUNK_SIZE - o_ptr->len;
+		if (x > size) x = size;
 
-		/* Release mutex */
-		pthread_mutex_unlock(&c->conn_mutex);
-		return;
-	}
+		/* Copy data */
+		memcpy(o_ptr->data + o_ptr->len, ptr, x);
 
-	/* Reduce buffer length by amount sent */
-	c->out_len -= x;
+		/* Advance past copied data */
+		o_ptr->len += x;
+		c->out_len += x;
+		ptr += x;
+		size -= x;
+	}
 
-	/* Shift buffer */
-	memmove(c->out_buf, c->out_buf + x, c->out_len);
+	/* Send immediately if socket was not already backed up */
+	if (was_empty) flush_conn(c);
 
 	/* Release connection mutex */
 	pthread_mutex_unlock(&c->conn_mutex);
 }
 
+/*
+ * Send a message to a client.
+ */
+void send_msg(int cid, char *msg)
+{
+	char *ptr;
+
+	/* Go to size area of message */
+	ptr = msg + 4;
+
+	/* Send message */
+	send_data(cid, msg, get_integer(&ptr));
+}
+
 /*
  * Create a new AI client connection.
  */
@@ -1318,8 +1842,12 @@ static int new_ai_client(int sid)
 	/* Clear buffer length */
 	c_list[i].buf_full = 0;
 
-	/* Clear outgoing buffer length */
-	c_list[i].out_len = 0;
+	/* Clear outgoing data queue */
+	pthread_mutex_lock(&c_list[i].conn_mutex);
+	clear_out_queue(&c_list[i]);
+	c_list[i].out_overflow = 0;
+	c_list[i].out_error = 0;
+	pthread_mutex_unlock(&c_list[i].conn_mutex);
 
 	/* Clear username */
 	strcpy(c_list[i].user, "AI client");
@@ -1357,6 +1885,9 @@ static void send_player(int who)
 {
 	int i;
 
+	/* Cached list of players is out of date */
+	players_valid = 0;
+
 	/* Loop over connections */
 	for (i = 0; i < num_conn; i++)
 	{
@@ -1374,79 +1905,203 @@ static void send_player(int who)
 
 /*
  * Send information about all connected players to a new client.
+ *
+ * The messages are encoded once and reused until a player changes.
  */
 static void send_all_players(int dest)
 {
-	int i;
+	char msg[1024], *ptr;
+	int i, size;
 
-	/* Loop over connections */
-	for (i = 0; i < num_conn; i++)
+	/* Check for out of date list */
+	if (!players_valid)
 	{
-		/* Skip non-active connections */
-		if (c_list[i].state != CS_LOBBY &&
-		    c_list[i].state != CS_PLAYING) continue;
+		/* Clear list */
+		players_len = 0;
 
-		/* Skip AI connections */
-		if (c_list[i].ai) continue;
+		/* Loop over connections */
+		for (i = 0; i < num_conn; i++)
+		{
+			/* Skip non-active connections */
+			if (c_list[i].state != CS_LOBBY &&
+			    c_list[i].state != CS_PLAYING) continue;
+
+			/* Skip AI connections */
+			if (c_list[i].ai) continue;
+
+			/* Start at beginning of message */
+			ptr = msg;
+
+			/* Create "new player" message */
+			start_msg(&ptr, MSG_PLAYER_NEW);
+			put_string(c_list[i].user, &ptr);
+			put_integer(c_list[i].state == CS_PLAYING, &ptr);
+			finish_msg(msg, ptr);
+
+			/* Get message size */
+			size = ptr - msg;
+
+			/* Check for insufficient room */
+			if (players_len + size > players_size)
+			{
+				/* Grow buffer */
+				players_size = 2 * players_size + 4096;
+				players_buf = (char *)realloc(players_buf,
+				                              players_size);
+			}
+
+			/* Add message to list */
+			memcpy(players_buf + players_len, msg, size);
+			players_len += size;
+		}
 
-		/* Send to player */
-		send_player_one(dest, i);
+		/* List is up to date */
+		players_valid = 1;
 	}
+
+	/* Send list to player */
+	if (players_len) send_data(dest, players_buf, players_len);
 }
 
 /*
- * Send information about an open game to a client.
+ * Check whether a client created or has joined a session.
+ *
+ * Such clients are sent slightly different information about the session.
  */
-static void send_session_one(int sid, int cid)
+static int session_involves(int sid, int cid)
 {
 	session *s_ptr = &s_list[sid];
-	char name[1024];
 	int i;
 
-	/* Check for game not in waiting status */
-	if (s_ptr->state != SS_WAITING)
-	{
-		/* Tell client that game is closed */
-		send_msgf(cid, MSG_CLOSE_GAME, "d", sid);
+	/* Check for no client */
+	if (cid < 0) return 0;
 
-		/* Done */
-		return;
+	/* Check for creator of session */
+	if (c_list[cid].uid == s_ptr->created) return 1;
+
+	/* Loop over players */
+	for (i = 0; i < s_ptr->num_users; i++)
+	{
+		/* Check for joined client */
+		if (s_ptr->cids[i] == cid) return 1;
 	}
 
+	/* Not involved */
+	return 0;
+}
+
+/*
+ * Encode information about an open game as seen by a given client.
+ *
+ * Use client -1 for clients not involved with the game.
+ *
+ * Return the size of the encoded messages.
+ */
+static int encode_session(int sid, int cid, char *buf)
+{
+	session *s_ptr = &s_list[sid];
+	char name[1024], *start, *ptr = buf;
+	int i;
+
 	/* Get username of game creator */
 	db_user_name(s_ptr->created, name);
 
-	/* Send message to client */
-	send_msgf(cid, MSG_OPENGAME, "dssddddddddd",
-	          sid, s_ptr->desc, name, strlen(s_ptr->pass) > 0,
-	          s_ptr->min_player, s_ptr->max_player,
-	          s_ptr->expanded, s_ptr->advanced, s_ptr->disable_goal,
-	          s_ptr->disable_takeover, s_ptr->speed,
-	          c_list[cid].uid == s_ptr->created);
+	/* Create open game message */
+	start = ptr;
+	start_msg(&ptr, MSG_OPENGAME);
+	put_integer(sid, &ptr);
+	put_string(s_ptr->desc, &ptr);
+	put_string(name, &ptr);
+	put_integer(strlen(s_ptr->pass) > 0, &ptr);
+	put_integer(s_ptr->min_player, &ptr);
+	put_integer(s_ptr->max_player, &ptr);
+	put_integer(s_ptr->expanded, &ptr);
+	put_integer(s_ptr->advanced, &ptr);
+	put_integer(s_ptr->disable_goal, &ptr);
+	put_integer(s_ptr->disable_takeover, &ptr);
+	put_integer(s_ptr->speed, &ptr);
+	put_integer(cid >= 0 && c_list[cid].uid == s_ptr->created, &ptr);
+	finish_msg(start, ptr);
 
 	/* Loop over player spots */
 	for (i = 0; i < MAX_PLAYER; i++)
 	{
+		/* Start player message */
+		start = ptr;
+		start_msg(&ptr, MSG_GAME_PLAYER);
+		put_integer(sid, &ptr);
+		put_integer(i, &ptr);
+
 		/* Check for empty player */
 		if (i >= s_ptr->num_users)
 		{
-			/* Send empty player spot */
-			send_msgf(cid, MSG_GAME_PLAYER, "ddsdd",
-			          sid, i, "", 0, 0);
+			/* Add empty player spot */
+			put_string("", &ptr);
+			put_integer(0, &ptr);
+			put_integer(0, &ptr);
+		}
+		else
+		{
+			/* Get user name for player */
+			db_user_name(s_ptr->uids[i], name);
 
-			/* Next spot */
-			continue;
+			/* Add joined player */
+			put_string(name, &ptr);
+			put_integer(s_ptr->ai_control[i] ||
+			            s_ptr->cids[i] != -1, &ptr);
+			put_integer(cid >= 0 && s_ptr->cids[i] == cid, &ptr);
 		}
 
-		/* Get user name for player */
-		db_user_name(s_ptr->uids[i], name);
+		/* Finish message */
+		finish_msg(start, ptr);
+	}
+
+	/* Return size */
+	return ptr - buf;
+}
+
+/*
+ * Send information about an open game to a client.
+ *
+ * Clients not involved with the game are sent a cached copy.
+ */
+static void send_session_one(int sid, int cid)
+{
+	session *s_ptr = &s_list[sid];
+	char msg[4096];
+
+	/* Check for game not in waiting status */
+	if (s_ptr->state != SS_WAITING)
+	{
+		/* Tell client that game is closed */
+		send_msgf(cid, MSG_CLOSE_GAME, "d", sid);
+
+		/* Done */
+		return;
+	}
+
+	/* Check for client who sees personal information */
+	if (session_involves(sid, cid))
+	{
+		/* Encode and send information */
+		send_data(cid, msg, encode_session(sid, cid, msg));
+
+		/* Done */
+		return;
+	}
+
+	/* Check for out of date cached information */
+	if (!s_ptr->lobby_valid)
+	{
+		/* Encode information */
+		s_ptr->lobby_len = encode_session(sid, -1, s_ptr->lobby_msg);
 
-		/* Send message about joined player */
-		send_msgf(cid, MSG_GAME_PLAYER, "ddsdd",
-		          sid, i, name,
-		          s_ptr->ai_control[i] || s_ptr->cids[i] != -1,
-		          s_ptr->cids[i] == cid);
+		/* Cached information is up to date */
+		s_ptr->lobby_valid = 1;
 	}
+
+	/* Send cached information */
+	send_data(cid, s_ptr->lobby_msg, s_ptr->lobby_len);
 }
 
 /*
@@ -1456,6 +2111,10 @@ static void send_session(int sid)
 {
 	int cid;
 
+	/* Cached information about session is out of date */
+	s_list[sid].lobby_valid = 0;
+	lobby_valid = 0;
+
 	/* Loop over connections */
 	for (cid = 0; cid < num_conn; cid++)
 	{
@@ -1473,21 +2132,88 @@ static void send_session(int sid)
 
 /*
  * Send information about all open sessions to a client.
+ *
+ * Clients not involved with any open session are sent a cached copy of
+ * the whole lobby in one buffer.
  */
 static void send_open_sessions(int cid)
 {
+	session *s_ptr;
 	int sid;
 
 	/* Loop over sessions */
 	for (sid = 0; sid < num_session; sid++)
 	{
-		/* Check for game waiting for players */
-		if (s_list[sid].state == SS_WAITING)
+		/* Check for open game involving client */
+		if (s_list[sid].state == SS_WAITING &&
+		    session_involves(sid, cid)) break;
+	}
+
+	/* Check for client involved in an open game */
+	if (sid < num_session)
+	{
+		/* Loop over sessions */
+		for (sid = 0; sid < num_session; sid++)
+		{
+			/* Check for game waiting for players */
+			if (s_list[sid].state == SS_WAITING)
+			{
+				/* Send game state */
+				send_session_one(sid, cid);
+			}
+		}
+
+		/* Done */
+		return;
+	}
+
+	/* Check for out of date lobby */
+	if (!lobby_valid)
+	{
+		/* Clear lobby */
+		lobby_len = 0;
+
+		/* Loop over sessions */
+		for (sid = 0; sid < num_session; sid++)
 		{
-			/* Send game state */
-			send_session_one(sid, cid);
+			/* Get session pointer */
+			s_ptr = &s_list[sid];
+
+			/* Skip games not waiting for players */
+			if (s_ptr->state != SS_WAITING) continue;
+
+			/* Check for out of date session information */
+			if (!s_ptr->lobby_valid)
+			{
+				/* Encode information */
+				s_ptr->lobby_len = encode_session(sid, -1,
+				                              s_ptr->lobby_msg);
+
+				/* Information is up to date */
+				s_ptr->lobby_valid = 1;
+			}
+
+			/* Check for insufficient room */
+			if (lobby_len + s_ptr->lobby_len > lobby_size)
+			{
+				/* Grow buffer */
+				lobby_size = 2 * lobby_size + 4096;
+				lobby_buf = (char *)realloc(lobby_buf,
+				                            lobby_size);
+			}
+
+			/* Add session to lobby */
+			memcpy(lobby_buf + lobby_len, s_ptr->lobby_msg,
+			       s_ptr->lobby_len);
+			lobby_len += s_ptr->lobby_len;
 		}
+
+		/* Lobby is up to date */
+		lobby_valid = 1;
 	}
+
+	/* Send lobby to client */
+	if (lobby_len) send_data(cid, lobby_buf, lobby_len);
 }
 
 /*
@@ -1554,7 +2280,7 @@ void message_add(game *g, char *txt)
 	char msg[1024], *ptr = msg;
 
 	/* Save message to db */
-	db_save_message(g->session_id, -1, txt, "");
+	db_save_message(g->session_id, -1, NULL, txt, "");
 
 	/* Create log message */
 	start_msg(&ptr, MSG_LOG);
@@ -1577,7 +2303,7 @@ void message_add_formatted(game *g, char *txt, char *tag)
 	char msg[1024], *ptr = msg;
 
 	/* Save message to db */
-	db_save_message(g->session_id, -1, txt, tag);
+	db_save_message(g->session_id, -1, NULL, txt, tag);
 
 	/* Create log message */
 	start_msg(&ptr, MSG_LOG_FORMAT);
@@ -1595,8 +2321,40 @@ void message_add_formatted(game *g, char *txt, char *tag)
 	send_to_session(g->session_id, msg);
 }
 
+/*
+ * Ask a session's worker to resume its game.
+ *
+ * Only the main thread may call this, so each worker's queue has a single
+ * producer and a single consumer and needs no lock.  A session is queued at
+ * most once at a time, so the queue cannot overflow.
+ */
+static void wake_session(int sid)
+{
+	session *s_ptr = &s_list[sid];
+	worker *w_ptr = &w_list[sid % num_worker];
+	unsigned int tail;
+
+	/* Do nothing if session is already queued */
+	if (__atomic_exchange_n(&s_ptr->queued, 1, __ATOMIC_ACQ_REL)) return;
+
+	/* Get position of next free slot */
+	tail = __atomic_load_n(&w_ptr->tail, __ATOMIC_RELAXED);
+
+	/* Add session to queue */
+	w_ptr->queue[tail % MAX_SESSION] = sid;
+
+	/* Publish new entry */
+	__atomic_store_n(&w_ptr->tail, tail + 1, __ATOMIC_RELEASE);
+
+	/* Wake worker */
+	sem_post(&w_ptr->ready);
+}
+
 /*
  * Wait for player to have an answer ready.
+ *
+ * Instead of blocking, the game switches back to its worker thread, and
+ * continues from here once the session is woken again.
  */
 static void server_wait(game *g, int who)
 {
@@ -1617,8 +2375,9 @@ static void server_wait(game *g, int who)
 			/* Log message */
 			server_log("S:%d waiting on player %d", g->session_id, who);
 
-			/* Wait for signal */
-			pthread_cond_wait(&s_ptr->wait_cond, &s_ptr->session_mutex);
+			/* Let worker run other games until input arrives */
+			swapcontext(&s_ptr->game_ctx,
+			            &w_list[g->session_id % num_worker].ctx);
 		}
 
 		/* Log message */
@@ -1671,6 +2430,9 @@ static void init_random_pool(int sid)
 
 	/* Start at beginning of pool */
 	s_ptr->random_pos = 0;
+
+	/* Seed stream for use after pool */
+	seed_random_stream(s_ptr);
 }
 
 /*
@@ -1694,8 +2456,8 @@ int game_rand(game *g)
 	/* Check for end of random bytes reached */
 	if (s_ptr->random_pos == MAX_RAND)
 	{
-		/* XXX Restart from beginning */
-		s_ptr->random_pos = 0;
+		/* Continue with stream seeded from pool */
+		return rng_next(&s_ptr->random_stream) & 0x7fff;
 	}
 
 	/* Create random number from next two bytes */
@@ -1818,6 +2580,13 @@ static void obfuscate_game(game *ob, game *g, int who)
 		ob->deck[j].owner = g->deck[i].owner;
 		ob->deck[j].start_where = g->deck[i].start_where;
 		ob->deck[j].start_owner = g->deck[i].start_owner;
+
+		/*
+		 * Clear covering card, since the substitute may be a card
+		 * that was left alone above (such as one of our goods that
+		 * has been reshuffled into the draw pile).
+		 */
+		ob->deck[j].covering = -1;
 	}
 
 	/* Loop over cards */
@@ -2276,9 +3045,6 @@ static void server_prepare(game *g, int who, int phase, int arg)
 	/* Don't prepare in simulated games */
 	if (g->simulation) return;
 
-	/* Don't ask AI players to prepare */
-	if (s_ptr->ai_control[who]) return;
-
 	/* Don't ask players who already have choices in log */
 	if (g->p[who].choice_size > g->p[who].choice_pos) return;
 
@@ -2390,7 +3156,7 @@ static void send_gamechat(int sid, int uid, char *user, char *text, int save)
 	char msg[1024], *ptr = msg;
 
 	/* Save message to db */
-	if (save) db_save_message(sid, uid, text, FORMAT_CHAT);
+	if (save) db_save_message(sid, uid, user, text, FORMAT_CHAT);
 
 	/* Start at beginning of message */
 	ptr = msg;
@@ -2429,12 +3195,21 @@ static void kick_player(int cid, char *reason)
 	/* Set state to disconnected */
 	c_list[cid].state = CS_DISCONN;
 
+	/* Grab connection mutex */
+	pthread_mutex_lock(&c_list[cid].conn_mutex);
+
 	/* Close connection */
 	close(c_list[cid].fd);
 
 	/* Clear file descriptor */
 	c_list[cid].fd = -1;
 
+	/* Discard unsent data */
+	clear_out_queue(&c_list[cid]);
+
+	/* Release connection mutex */
+	pthread_mutex_unlock(&c_list[cid].conn_mutex);
+
 	/* Send disconnect to everyone */
 	send_player(cid);
 
@@ -2660,8 +3435,8 @@ static void handle_choice(int cid, char *ptr, int size)
 	/* Mark time of activity */
 	c_list[cid].last_active = time(NULL);
 
-	/* Signal game thread to continue */
-	pthread_cond_signal(&s_ptr->wait_cond);
+	/* Have game continue */
+	wake_session(sid);
 
 	/* Update waiting status */
 	update_waiting(sid);
@@ -2707,8 +3482,8 @@ static void handle_prepare(int cid, char *ptr)
 		server_log("S:%d P:%d READY", sid, who);
 	}
 
-	/* Signal game thread to continue */
-	pthread_cond_signal(&s_ptr->wait_cond);
+	/* Have game continue */
+	wake_session(sid);
 
 	/* Update waiting status */
 	update_waiting(sid);
@@ -2735,7 +3510,7 @@ void server_private_message(game *g, int who, char *txt, char *tag)
 	uid = s_list[g->session_id].uids[who];
 
 	/* Save message to db */
-	db_save_message(g->session_id, uid, txt, tag);
+	db_save_message(g->session_id, uid, NULL, txt, tag);
 
 	/* Check for no connection */
 	if (cid < 0) return;
@@ -2828,8 +3603,12 @@ static void accept_conn(int listen_fd)
 	/* Clear buffer length */
 	c_list[i].buf_full = 0;
 
-	/* Clear outgoing buffer length */
-	c_list[i].out_len = 0;
+	/* Clear outgoing data queue */
+	pthread_mutex_lock(&c_list[i].conn_mutex);
+	clear_out_queue(&c_list[i]);
+	c_list[i].out_overflow = 0;
+	c_list[i].out_error = 0;
+	pthread_mutex_unlock(&c_list[i].conn_mutex);
 
 	/* Clear username */
 	strcpy(c_list[i].user, "");
@@ -3035,19 +3814,14 @@ static void switch_ai(int sid, int who)
 /*
  * Run a started game.
  *
- * This function runs in a new thread.
+ * This function runs as a coroutine on the session's worker thread, which
+ * holds the session mutex whenever the game is running.
  */
-void *run_game(void *arg)
+static void run_game(int sid)
 {
-	session *s_ptr = (session *)arg;
+	session *s_ptr = &s_list[sid];
 	int i;
 
-	/* Initialize condition variable */
-	pthread_cond_init(&s_ptr->wait_cond, NULL);
-
-	/* Acquire session mutex */
-	pthread_mutex_lock(&s_ptr->session_mutex);
-
 	/* Initialize game */
 	init_game(&s_ptr->g);
 
@@ -3110,19 +3884,118 @@ void *run_game(void *arg)
 	/* Mark session as finished */
 	s_ptr->state = SS_DONE;
 
-	/* Release mutex */
+	/* Mark game as no longer running */
+	s_ptr->game_done = 1;
+}
+
+/*
+ * Run a session's game until it must wait for input or is finished.
+ *
+ * Called by the session's worker thread.
+ */
+static void resume_game(worker *w_ptr, int sid)
+{
+	session *s_ptr = &s_list[sid];
+	int done;
+
+	/* Acquire session mutex */
+	pthread_mutex_lock(&s_ptr->session_mutex);
+
+	/* Check for no game running */
+	if (!s_ptr->game_stack)
+	{
+		/* Release session mutex */
+		pthread_mutex_unlock(&s_ptr->session_mutex);
+		return;
+	}
+
+	/* Run game until it waits for input or finishes */
+	swapcontext(&w_ptr->ctx, &s_ptr->game_ctx);
+
+	/* Remember whether game finished */
+	done = s_ptr->game_done;
+
+	/* Check for finished game */
+	if (done)
+	{
+		/* Free game stack */
+		free(s_ptr->game_stack);
+		s_ptr->game_stack = NULL;
+	}
+
+	/* Release session mutex */
 	pthread_mutex_unlock(&s_ptr->session_mutex);
 
-	/* Save state */
-	db_save_game_state(s_ptr->sid);
+	/* Check for finished game */
+	if (done)
+	{
+		/* Save state */
+		db_save_game_state(s_ptr->sid);
+
+		/* Save results */
+		db_save_results(s_ptr->sid);
+	}
+}
+
+/*
+ * Run games belonging to one worker as their sessions are woken.
+ *
+ * This function runs in a new thread.
+ */
+static void *run_worker(void *arg)
+{
+	worker *w_ptr = (worker *)arg;
+	unsigned int head;
+	int sid;
+
+	/* Loop forever */
+	while (1)
+	{
+		/* Wait for a session to be queued */
+		while (sem_wait(&w_ptr->ready) && errno == EINTR) ;
+
+		/* Get position of next queued session */
+		head = w_ptr->head;
+
+		/* Take session from queue */
+		sid = w_ptr->queue[head % MAX_SESSION];
 
-	/* Save results */
-	db_save_results(s_ptr->sid);
+		/* Free queue slot */
+		__atomic_store_n(&w_ptr->head, head + 1, __ATOMIC_RELEASE);
 
-	/* Done */
+		/* Allow session to be queued again */
+		__atomic_store_n(&s_list[sid].queued, 0, __ATOMIC_RELEASE);
+
+		/* Run game */
+		resume_game(w_ptr, sid);
+	}
+
+	/* Not reached */
 	return NULL;
 }
 
+/*
+ * Start the game worker threads.
+ */
+static void start_workers(void)
+{
+	int i;
+
+	/* Loop over workers */
+	for (i = 0; i < num_worker; i++)
+	{
+		/* Clear queue */
+		w_list[i].head = w_list[i].tail = 0;
+
+		/* Initialize count of queued sessions */
+		sem_init(&w_list[i].ready, 0, 0);
+
+		/* Start thread */
+		pthread_create(&w_list[i].thread, NULL, run_worker,
+		               (void *)&w_list[i]);
+	}
+}
+
 /*
  * Start a game session.
  */
@@ -3130,7 +4003,6 @@ static void start_session(int sid)
 {
 	session *s_ptr = &s_list[sid];
 	char name[80];
-	pthread_t t;
 	int i;
 
 	/* Check for advanced flag and more than two players */
@@ -3200,8 +4072,25 @@ static void start_session(int sid)
 		db_save_seats(sid);
 	}
 
-	/* Start a thread to run game */
-	pthread_create(&t, NULL, run_game, (void *)s_ptr);
+	/* Create context for game to run in */
+	getcontext(&s_ptr->game_ctx);
+
+	/* Give game its own stack */
+	s_ptr->game_stack = (char *)malloc(GAME_STACK_SIZE);
+	s_ptr->game_ctx.uc_stack.ss_sp = s_ptr->game_stack;
+	s_ptr->game_ctx.uc_stack.ss_size = GAME_STACK_SIZE;
+
+	/* Return to worker when game is finished */
+	s_ptr->game_ctx.uc_link = &w_list[sid % num_worker].ctx;
+
+	/* Game is not finished */
+	s_ptr->game_done = 0;
+
+	/* Set game to start at beginning */
+	makecontext(&s_ptr->game_ctx, (void (*)(void))run_game, 1, sid);
+
+	/* Have worker start game */
+	wake_session(sid);
 }
 
 /*
@@ -3454,7 +4343,7 @@ static void handle_login(int cid, char *ptr)
 			send_msgf(cid, MSG_START, "");
 
 			/* Replay game messages */
-			replay_messages(s_ptr->gid, cid);
+			replay_messages(i, cid);
 
 			/* Client is playing */
 			c_list[cid].state = CS_PLAYING;
@@ -3566,6 +4455,13 @@ static void handle_create(int cid, char *ptr)
 	/* Initialize session mutex */
 	pthread_mutex_init(&s_ptr->session_mutex, NULL);
 
+	/* Initialize message history */
+	pthread_mutex_init(&s_ptr->hist_mutex, NULL);
+	s_ptr->hist_gid = -1;
+
+	/* No cached lobby information */
+	s_ptr->lobby_valid = 0;
+
 	/* Set session state */
 	s_ptr->state = SS_WAITING;
 
@@ -3746,6 +4642,11 @@ static void abandon_session(int sid)
 
 	/* Set game state to empty */
 	s_ptr->state = SS_EMPTY;
+
+	/* Discard cached message history */
+	pthread_mutex_lock(&s_ptr->hist_mutex);
+	clear_history(s_ptr);
+	pthread_mutex_unlock(&s_ptr->hist_mutex);
 }
 
 /*
@@ -4384,6 +5285,11 @@ static void do_housekeeping(void)
 
 			/* Mark session as empty once more */
 			s_ptr->state = SS_EMPTY;
+
+			/* Discard cached message history */
+			pthread_mutex_lock(&s_ptr->hist_mutex);
+			clear_history(s_ptr);
+			pthread_mutex_unlock(&s_ptr->hist_mutex);
 		}
 	}
 
@@ -4608,6 +5514,7 @@ int main(int argc, char *argv[])
 			printf("  -k     Timeout to replace players with A.I. in ticks (%d seconds).\n", tick_size);
 			printf("            0 means do not replace players. Default: 30\n");
 			printf("  -gt    Timeout to drop games that haven't been started yet. Default: 3600\n");
+			printf("  -w     Number of threads to run games on. Default: 4\n");
 			printf("  -e     Folder to put exported games. Default: \".\"\n");
 			printf("  -s     Server name (to be used in exports). Default: [none]\n");
 			printf("  -ss    XSLT style sheets for exported games. Default: [none]\n");
@@ -4654,6 +5561,17 @@ int main(int argc, char *argv[])
 			game_timeout = atoi(argv[++i]);
 		}
 
+		/* Check for number of game threads */
+		if (!strcmp(argv[i], "-w"))
+		{
+			/* Set number of game threads */
+			num_worker = atoi(argv[++i]);
+
+			/* Keep number in range */
+			if (num_worker < 1) num_worker = 1;
+			if (num_worker > MAX_WORKER) num_worker = MAX_WORKER;
+		}
+
 		/* Check for server name */
 		if (!strcmp(argv[i], "-s"))
 		{
@@ -4716,6 +5634,9 @@ int main(int argc, char *argv[])
 	db_load_sessions();
 	db_load_attendance();
 
+	/* Start threads to run games */
+	start_workers();
+
 	/* Start sessions that were running previously */
 	start_all_sessions();
 
@@ -4836,8 +5757,28 @@ int main(int argc, char *argv[])
 				/* Check for unsent data ready to send */
 				if (FD_ISSET(c_list[i].fd, &writefds))
 				{
-					/* Send ping to flush buffer */
-					send_msgf(i, MSG_PING, "");
+					/* Grab connection mutex */
+					pthread_mutex_lock(&c_list[i].conn_mutex);
+
+					/* Send queued data */
+					flush_conn(&c_list[i]);
+
+					/* Release connection mutex */
+					pthread_mutex_unlock(&c_list[i].conn_mutex);
+				}
+
+				/* Check for client unable to keep up */
+				if (c_list[i].out_overflow)
+				{
+					/* Remove client */
+					kick_player(i, "Output backlog exceeded");
+				}
+
+				/* Check for failed send */
+				else if (c_list[i].out_error)
+				{
+					/* Remove client */
+					kick_player(i, "Write error");
 				}
 			}
 		}
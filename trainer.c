@@ -0,0 +1,518 @@
+/*
+ * Race for the Galaxy AI
+ *
+ * Copyright (C) 2009-2011 Keldon Jones
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Offline trainer for the evaluation network.
+ *
+ * Reads positions recorded by "learner -d", then trains a network on
+ * them for a number of epochs.  Each epoch visits the positions in a new
+ * random order, in mini-batches.  Each thread trains its own copy of the
+ * network on a batch of positions, and the corrections of every thread
+ * are applied together once all have finished.  Only the weight rows of
+ * inputs a thread saw are merged.
+ *
+ * In "Hogwild" mode the threads instead train one shared set of weights
+ * directly, without locking.  Only the correction shared by inputs left
+ * at their default value is collected and applied after each batch.
+ * Since the weights change under them, these threads compute every
+ * position from scratch.
+ *
+ * The threads are started once, and wait at a barrier between batches.
+ *
+ * Build with "make trainer".
+ */
+
+#include "net.h"
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+/*
+ * A training thread.
+ */
+typedef struct trainer
+{
+	/* Thread */
+	pthread_t thread;
+
+	/* Private copy of network */
+	net learn;
+
+	/* Network being trained */
+	net *master;
+
+	/* Range of positions to train */
+	int first, last;
+
+	/* Copy weights from master before training */
+	int copy;
+
+} trainer;
+
+/*
+ * Recorded positions.
+ */
+static net_sample *samples;
+static int num_sample;
+
+/*
+ * Order to visit positions in.
+ */
+static int *order;
+
+/*
+ * Barriers at the start and end of each mini-batch.
+ */
+static pthread_barrier_t batch_start, batch_done;
+
+/*
+ * Set when training is finished and threads should exit.
+ */
+static int training_done;
+
+/*
+ * Train one thread's batch of each mini-batch, until training is done.
+ */
+static void *run_trainer(void *arg)
+{
+	trainer *t_ptr = (trainer *)arg;
+	int i;
+
+	/* Loop until done */
+	while (1)
+	{
+		/* Wait for next mini-batch */
+		pthread_barrier_wait(&batch_start);
+
+		/* Check for end of training */
+		if (training_done) break;
+
+		/* Copy current weights unless shared */
+		if (t_ptr->copy) copy_weights(&t_ptr->learn, t_ptr->master);
+
+		/* Loop over positions */
+		for (i = t_ptr->first; i < t_ptr->last; i++)
+		{
+			/*
+			 * Shared weights change with every position trained,
+			 * so sums kept from the last position are stale.
+			 */
+			if (!t_ptr->copy) clear_sums(&t_ptr->learn);
+
+			/* Train position */
+			train_sample(&t_ptr->learn, &samples[order[i]]);
+		}
+
+		/* Batch finished */
+		pthread_barrier_wait(&batch_done);
+	}
+
+	/* Done */
+	return NULL;
+}
+
+/*
+ * Read the size of a network from its weights file.
+ *
+ * Return 0 on success.
+ */
+static int read_net_size(char *fname, int *input, int *hidden, int *output)
+{
+	FILE *fff;
+	int header[4];
+	char buf[1024];
+
+	/* Open weights file */
+	fff = fopen(fname, "rb");
+
+	/* Check for failure */
+	if (!fff) return -1;
+
+	/* Read start of file */
+	if (fread(header, sizeof(int), 4, fff) != 4)
+	{
+		/* Failure */
+		fclose(fff);
+		return -1;
+	}
+
+	/* Check for binary file */
+	if (header[0] == 0x47746652)
+	{
+		/* Copy size */
+		*input = header[1];
+		*hidden = header[2];
+		*output = header[3];
+	}
+	else
+	{
+		/* Go back to start */
+		rewind(fff);
+
+		/* Read first line */
+		if (!fgets(buf, 1024, fff) ||
+		    sscanf(buf, "%d %d %d", input, hidden, output) != 3)
+		{
+			/* Failure */
+			fclose(fff);
+			return -1;
+		}
+	}
+
+	/* Done */
+	fclose(fff);
+
+	/* Success */
+	return 0;
+}
+
+/*
+ * Train a network on recorded self-play positions.
+ */
+int main(int argc, char *argv[])
+{
+	net learn;
+	trainer *threads;
+	FILE *fff;
+	char *net_name = NULL, *data_name = NULL, *out_name = NULL;
+	char *check_name = NULL;
+	int input, hidden, output;
+	int epochs = 10, batch = 256, num_thread, binary = 0, hogwild = 0;
+	int i, j, k, x, n, size, per;
+	double alpha = 0.0001;
+	struct timespec start, end;
+	double secs;
+
+	/* Use all processors by default */
+	num_thread = sysconf(_SC_NPROCESSORS_ONLN);
+	if (num_thread < 1) num_thread = 1;
+
+	/* Set random seed */
+	srand(time(NULL));
+
+	/* Parse arguments */
+	for (i = 1; i < argc; i++)
+	{
+		/* Check for number of epochs */
+		if (!strcmp(argv[i], "-e"))
+		{
+			/* Set number of epochs */
+			epochs = atoi(argv[++i]);
+		}
+
+		/* Check for batch size */
+		else if (!strcmp(argv[i], "-b"))
+		{
+			/* Set batch size */
+			batch = atoi(argv[++i]);
+		}
+
+		/* Check for learning rate */
+		else if (!strcmp(argv[i], "-a"))
+		{
+			/* Set learning rate */
+			alpha = atof(argv[++i]);
+		}
+
+		/* Check for number of threads */
+		else if (!strcmp(argv[i], "-t"))
+		{
+			/* Set number of threads */
+			num_thread = atoi(argv[++i]);
+		}
+
+		/* Check for random seed */
+		else if (!strcmp(argv[i], "-r"))
+		{
+			/* Set random seed */
+			srand(atoi(argv[++i]));
+		}
+
+		/* Check for binary output */
+		else if (!strcmp(argv[i], "-B"))
+		{
+			/* Save binary weights */
+			binary = 1;
+		}
+
+		/* Check for Hogwild training */
+		else if (!strcmp(argv[i], "-H"))
+		{
+			/* Train shared weights */
+			hogwild = 1;
+		}
+
+		/* Check for checkpoint file */
+		else if (!strcmp(argv[i], "-c"))
+		{
+			/* Set checkpoint file */
+			check_name = argv[++i];
+		}
+
+		/* Check for network file */
+		else if (!net_name) net_name = argv[i];
+
+		/* Check for dataset file */
+		else if (!data_name) data_name = argv[i];
+
+		/* Output file */
+		else out_name = argv[i];
+	}
+
+	/* Check for missing files */
+	if (!net_name || !data_name)
+	{
+		/* Print usage */
+		printf("Usage: trainer [options] <network> <dataset> "
+		       "[output]\n\n");
+		printf("Options:\n");
+		printf("  -e     Number of epochs. Default: 10\n");
+		printf("  -b     Positions per thread in each mini-batch. "
+		       "Default: 256\n");
+		printf("  -a     Learning rate. Default: 0.0001\n");
+		printf("  -t     Number of threads. Default: processors\n");
+		printf("  -r     Random seed for shuffling.\n");
+		printf("  -B     Save binary weights.\n");
+		printf("  -H     Hogwild: threads share weights.\n");
+		printf("  -c     Save binary checkpoint after each epoch.\n\n");
+		printf("The trained network replaces <network> if no output "
+		       "is given.\n");
+		exit(1);
+	}
+
+	/* Validate settings */
+	if (batch < 1) batch = 1;
+	if (num_thread < 1) num_thread = 1;
+
+	/* Save over input if no output given */
+	if (!out_name) out_name = net_name;
+
+	/* Read network size */
+	if (read_net_size(net_name, &input, &hidden, &output))
+	{
+		/* Error */
+		printf("Couldn't read network size from %s\n", net_name);
+		exit(1);
+	}
+
+	/* Create network */
+	make_learner(&learn, input, hidden, output);
+
+	/* Load weights */
+	if (load_net(&learn, net_name))
+	{
+		/* Error */
+		printf("Couldn't load %s\n", net_name);
+		exit(1);
+	}
+
+	/* Open dataset */
+	fff = fopen(data_name, "rb");
+
+	/* Check for failure */
+	if (!fff)
+	{
+		/* Error */
+		perror(data_name);
+		exit(1);
+	}
+
+	/* Start with room for some positions */
+	size = 1024;
+	samples = (net_sample *)malloc(sizeof(net_sample) * size);
+
+	/* Read positions */
+	while ((x = read_sample(&learn, fff, &samples[num_sample])) > 0)
+	{
+		/* Count position */
+		num_sample++;
+
+		/* Check for full list */
+		if (num_sample == size)
+		{
+			/* Grow list */
+			size *= 2;
+			samples = (net_sample *)realloc(samples,
+			                   sizeof(net_sample) * size);
+		}
+	}
+
+	/* Done with dataset */
+	fclose(fff);
+
+	/* Check for bad record */
+	if (x < 0)
+	{
+		/* Error */
+		printf("Dataset %s does not match network "
+		       "(after %d positions)\n", data_name, num_sample);
+		exit(1);
+	}
+
+	/* Check for no data */
+	if (!num_sample)
+	{
+		/* Error */
+		printf("No positions in %s\n", data_name);
+		exit(1);
+	}
+
+	/* Print size of data */
+	printf("Read %d positions\n", num_sample);
+
+	/* Create visiting order */
+	order = (int *)malloc(sizeof(int) * num_sample);
+	for (i = 0; i < num_sample; i++) order[i] = i;
+
+	/* Create threads */
+	threads = (trainer *)malloc(sizeof(trainer) * num_thread);
+
+	/* Create barriers for threads and ourself */
+	pthread_barrier_init(&batch_start, NULL, num_thread + 1);
+	pthread_barrier_init(&batch_done, NULL, num_thread + 1);
+
+	/* Loop over threads */
+	for (i = 0; i < num_thread; i++)
+	{
+		/* Create private network */
+		make_learner(&threads[i].learn, input, hidden, output);
+
+		/* Set learning rate */
+		threads[i].learn.alpha = alpha;
+
+		/* Remember network being trained */
+		threads[i].master = &learn;
+
+		/* Train shared weights in Hogwild mode */
+		if (hogwild) share_weights(&threads[i].learn, &learn);
+
+		/* Copy weights each batch unless shared */
+		threads[i].copy = !hogwild;
+
+		/* Start thread */
+		pthread_create(&threads[i].thread, NULL, run_trainer,
+		               &threads[i]);
+	}
+
+	/* Start timer */
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	/* Loop over epochs */
+	for (i = 0; i < epochs; i++)
+	{
+		/* Shuffle positions */
+		for (j = num_sample - 1; j > 0; j--)
+		{
+			/* Pick position to swap with */
+			k = rand() % (j + 1);
+
+			/* Swap */
+			x = order[j];
+			order[j] = order[k];
+			order[k] = x;
+		}
+
+		/* Clear error counters */
+		learn.error = learn.num_error = 0;
+
+		/* Loop over mini-batches */
+		for (j = 0; j < num_sample; j += batch * num_thread)
+		{
+			/* Get size of this mini-batch */
+			n = num_sample - j;
+			if (n > batch * num_thread) n = batch * num_thread;
+
+			/* Compute positions per thread */
+			per = (n + num_thread - 1) / num_thread;
+
+			/* Loop over threads */
+			for (k = 0; k < num_thread; k++)
+			{
+				/* Set range of positions */
+				threads[k].first = j + k * per;
+				threads[k].last = j + (k + 1) * per;
+
+				/* Stop at end of mini-batch */
+				if (threads[k].first > j + n)
+					threads[k].first = j + n;
+				if (threads[k].last > j + n)
+					threads[k].last = j + n;
+			}
+
+			/* Start threads */
+			pthread_barrier_wait(&batch_start);
+
+			/* Wait for threads to finish */
+			pthread_barrier_wait(&batch_done);
+
+			/* Loop over threads */
+			for (k = 0; k < num_thread; k++)
+			{
+				/* Collect corrections and error counters */
+				add_deltas(&learn, &threads[k].learn);
+			}
+
+			/* Apply corrections */
+			apply_training(&learn);
+		}
+
+		/* Count training iteration */
+		learn.num_training++;
+
+		/* Print error */
+		printf("Epoch %d: error %f\n", i + 1,
+		       learn.error / learn.num_error);
+
+		/* Save checkpoint */
+		if (check_name) save_net_bin(&learn, check_name);
+	}
+
+	/* Stop timer */
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	/* Tell threads to exit */
+	training_done = 1;
+	pthread_barrier_wait(&batch_start);
+
+	/* Loop over threads */
+	for (i = 0; i < num_thread; i++)
+	{
+		/* Wait for thread */
+		pthread_join(threads[i].thread, NULL);
+	}
+
+	/* Compute elapsed time */
+	secs = (end.tv_sec - start.tv_sec) +
+	       (end.tv_nsec - start.tv_nsec) / 1e9;
+
+	/* Avoid dividing by zero */
+	if (secs <= 0) secs = 0.001;
+
+	/* Print training speed */
+	printf("Trained %.0f positions per second\n",
+	       (double)num_sample * epochs / secs);
+
+	/* Save trained network */
+	if (binary) save_net_bin(&learn, out_name);
+	else save_net(&learn, out_name);
+
+	/* Done */
+	return 0;
+}
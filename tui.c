@@ -119,7 +119,8 @@ CommandOutcome handle_common_commands(game *g, char *input, int who)
         
         printf("Game Information:\n");
         printf("  v          - Show victory points for all players\n");
-        printf("  m          - Show military strength for all players\n\n");
+        printf("  m          - Show military strength for all players\n");
+        printf("  e          - Show recent game events\n\n");
         
         printf("Game Control:\n");
         printf("  q          - Quit the game\n");
@@ -165,6 +166,11 @@ CommandOutcome handle_common_commands(game *g, char *input, int who)
         display_military(g);
         return CMD_HANDLED;
     }
+    else if (strcmp(input, "e") == 0)
+    {
+        display_events(g, who);
+        return CMD_HANDLED;
+    }
     else if (input[0] == 't')
     {
         int player_number = -1; // Default to -1 to indicate the human player
@@ -2104,6 +2110,50 @@ void display_military(game *g)
     }
 }
 
+/* Number of events shown by the 'e' command */
+#define RECENT_EVENTS 20
+
+/*
+ * Display the most recent public events from the game's event log.
+ *
+ * Events are only rendered as text here, when they are asked for.
+ */
+void display_events(game *g, int who)
+{
+    game_event *recent[RECENT_EVENTS], *e;
+    uint32_t pos = 0;
+    int i, n = 0;
+    char buf[1024];
+
+    /* Check for no log */
+    if (!g->events)
+    {
+        printf("No event log for this game.\n");
+        return;
+    }
+
+    printf("=== Recent Events ===\n\n");
+
+    /* Read log, remembering the last few public events */
+    while ((e = next_event(g, &pos)))
+    {
+        /* Hide cards moving anywhere but into a tableau */
+        if (e->type == EVENT_MOVE && e->arg[3] != WHERE_ACTIVE) continue;
+
+        /* Hide other players' choices */
+        if (e->type == EVENT_CHOICE && e->who != who) continue;
+
+        recent[n++ % RECENT_EVENTS] = e;
+    }
+
+    /* Format and print remembered events */
+    for (i = n > RECENT_EVENTS ? n - RECENT_EVENTS : 0; i < n; i++)
+    {
+        format_event(g, recent[i % RECENT_EVENTS], buf);
+        printf("%s", buf);
+    }
+}
+
 /*
  * Display campaign selection menu and get user choice.
  * Returns selected campaign name or NULL for no campaign.